@@ -0,0 +1,117 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "../../../assert.hpp"
+
+namespace sek
+{
+	namespace detail
+	{
+		/* Debug-only tracker of concurrent access to a component set. Positive state is the amount of active readers,
+		 * `-1` indicates an active writer. In release builds (`NDEBUG`) the tracker is empty and all checks are no-op. */
+		class access_tracker
+		{
+		public:
+			constexpr access_tracker() noexcept = default;
+
+			/* Access state belongs to a specific set instance, thus it is never moved. */
+			constexpr access_tracker(access_tracker &&) noexcept {}
+			constexpr access_tracker &operator=(access_tracker &&) noexcept { return *this; }
+
+#ifndef NDEBUG
+			void acquire_read() noexcept
+			{
+				auto state = m_state.load(std::memory_order_relaxed);
+				do
+					SEK_ASSERT(state >= 0, "Component set is read while being written to by another thread");
+				while (!m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed));
+			}
+			void release_read() noexcept { m_state.fetch_sub(1, std::memory_order_release); }
+
+			void acquire_write() noexcept
+			{
+				std::ptrdiff_t state = 0;
+				[[maybe_unused]] const auto success = m_state.compare_exchange_strong(state, -1, std::memory_order_acquire);
+				SEK_ASSERT(success, "Component set is written to while being accessed by another thread");
+			}
+			void release_write() noexcept { m_state.store(0, std::memory_order_release); }
+
+			/* Checks that the set is not being read, used by mutating functions of the set. */
+			void assert_writable() const noexcept
+			{
+				SEK_ASSERT(m_state.load(std::memory_order_relaxed) <= 0,
+						   "Component set is modified while being read by another thread");
+			}
+
+		private:
+			std::atomic<std::ptrdiff_t> m_state = 0;
+#else
+			constexpr void acquire_read() noexcept {}
+			constexpr void release_read() noexcept {}
+			constexpr void acquire_write() noexcept {}
+			constexpr void release_write() noexcept {}
+			constexpr void assert_writable() const noexcept {}
+#endif
+		};
+	}	 // namespace detail
+
+	/** @brief Scoped guard used to declare shared (read) or exclusive (write) access to a component set.
+	 *
+	 * In debug builds, conflicting access (a writer concurrent with any other guard, or modification of a set
+	 * while it is being read) triggers an assertion. In release builds (`NDEBUG`) guards are no-op.
+	 *
+	 * @tparam IsWrite Whether the guard declares exclusive (write) access. */
+	template<bool IsWrite>
+	class component_access_guard
+	{
+	public:
+		component_access_guard(const component_access_guard &) = delete;
+		component_access_guard &operator=(const component_access_guard &) = delete;
+
+		constexpr component_access_guard() noexcept = default;
+		constexpr component_access_guard(component_access_guard &&other) noexcept { swap(other); }
+		constexpr component_access_guard &operator=(component_access_guard &&other) noexcept
+		{
+			swap(other);
+			return *this;
+		}
+
+		/** Acquires access using the specified tracker. */
+		constexpr explicit component_access_guard(detail::access_tracker &tracker) noexcept : m_tracker(&tracker)
+		{
+			if constexpr (IsWrite)
+				m_tracker->acquire_write();
+			else
+				m_tracker->acquire_read();
+		}
+		constexpr ~component_access_guard() { release(); }
+
+		/** Releases the access early. */
+		constexpr void release() noexcept
+		{
+			if (m_tracker == nullptr) return;
+
+			if constexpr (IsWrite)
+				m_tracker->release_write();
+			else
+				m_tracker->release_read();
+			m_tracker = nullptr;
+		}
+
+		constexpr void swap(component_access_guard &other) noexcept { std::swap(m_tracker, other.m_tracker); }
+		friend constexpr void swap(component_access_guard &a, component_access_guard &b) noexcept { a.swap(b); }
+
+	private:
+		detail::access_tracker *m_tracker = nullptr;
+	};
+
+	typedef component_access_guard<false> component_read_guard;
+	typedef component_access_guard<true> component_write_guard;
+}	 // namespace sek
@@ -10,7 +10,7 @@
 
 namespace sek
 {
-	template<typename, typename = included_t<>, typename = excluded_t<>, typename = optional_t<>>
+	template<typename, typename = included_t<>, typename = excluded_t<>, typename = optional_t<>, typename = enabled_t<>>
 	class component_collection;
 
 	/** @brief Structure used to own and provide a view of components for a set of entities.
@@ -48,14 +48,14 @@ namespace sek
 	 * @tparam I Component types captured by the collection.
 	 * @tparam E Component types excluded from the collection.
 	 * @tparam P Optional components of the collection.
-	 * @tparam Alloc Allocator used for internal entity set. */
-	template<typename... O, typename... I, typename... E, typename... P>
-	class component_collection<owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>>
+	 * @tparam Q Owned or included components, entities of which are only accepted while the component is enabled. */
+	template<typename... O, typename... I, typename... E, typename... P, typename... Q>
+	class component_collection<owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>
 	{
-		template<typename, typename, typename, typename, typename>
+		template<typename, typename, typename, typename, typename, typename>
 		friend class entity_query;
 
-		using handler_t = detail::collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>>;
+		using handler_t = detail::collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>>;
 
 		template<typename T>
 		using set_ptr_t = transfer_cv_t<T, component_set<std::remove_cv_t<T>>> *;
@@ -376,13 +376,13 @@ namespace sek
 	};
 
 	/** @brief Non-owning specialization of `component_collection`. */
-	template<typename... I, typename... E, typename... P>
-	class component_collection<owned_t<>, included_t<I...>, excluded_t<E...>, optional_t<P...>>
+	template<typename... I, typename... E, typename... P, typename... Q>
+	class component_collection<owned_t<>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>
 	{
-		template<typename, typename, typename, typename, typename>
+		template<typename, typename, typename, typename, typename, typename>
 		friend class entity_query;
 
-		using handler_t = detail::collection_handler<owned_t<>, included_t<I...>, excluded_t<E...>>;
+		using handler_t = detail::collection_handler<owned_t<>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>>;
 
 		template<typename T>
 		using set_ptr_t = transfer_cv_t<T, component_set<std::remove_cv_t<T>>> *;
@@ -4,14 +4,52 @@
 
 #pragma once
 
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "../../../dense_map.hpp"
 #include "../../../detail/alloc_util.hpp"
 #include "../../../event.hpp"
 #include "../../../meta.hpp"
 #include "../../../type_info.hpp"
+#include "access_guard.hpp"
 #include "entity_set.hpp"
+#include "event_queue.hpp"
+#include "unique_index.hpp"
 
 namespace sek
 {
+	/** @brief Type-erased run of components stored contiguously in memory.
+	 * Component at index `i` of the run is located at `data + i * stride` bytes.
+	 * @note Components of empty types share the same instance, thus runs of such components have a stride of `0`. */
+	template<bool IsConst>
+	struct basic_any_span
+	{
+		typedef std::conditional_t<IsConst, const void, void> element_type;
+
+		/** Returns pointer to the component at the specified index of the run. */
+		[[nodiscard]] constexpr element_type *get(std::size_t i) const noexcept
+		{
+			using byte_t = std::conditional_t<IsConst, const std::byte, std::byte>;
+			return static_cast<byte_t *>(data) + i * stride;
+		}
+
+		/** Type of the components. */
+		type_info type;
+		/** Pointer to the first component of the run. */
+		element_type *data;
+		/** Distance in bytes between consecutive components. */
+		std::size_t stride;
+		/** Amount of components in the run. */
+		std::size_t size;
+	};
+
+	typedef basic_any_span<false> any_span;
+	typedef basic_any_span<true> const_any_span;
+
 	/** @brief Structure used to store a set of entities and provide a type-erased access to their components. */
 	class generic_component_set : basic_entity_set<std::allocator<entity_t>>
 	{
@@ -92,6 +130,8 @@ namespace sek
 		[[nodiscard]] constexpr size_type size() const noexcept { return base_set::size(); }
 		/** @copydoc base_set::empty */
 		[[nodiscard]] constexpr bool empty() const noexcept { return base_set::empty(); }
+		/** @copydoc base_set::layout_version */
+		[[nodiscard]] constexpr size_type layout_version() const noexcept { return base_set::layout_version(); }
 		/** @copydoc base_set::contains */
 		[[nodiscard]] constexpr bool contains(entity_t entity) const noexcept { return base_set::contains(entity); }
 
@@ -138,6 +178,45 @@ namespace sek
 		/** @copydoc get_any */
 		[[nodiscard]] virtual any_ref get_any(entity_t entity) const noexcept = 0;
 
+		/** Returns a type-erased run of components stored contiguously starting at the specified offset. Runs end at
+		 * the end of a storage page (or at a locked component), thus the entire set can be accessed with one call per run.
+		 * @note Component at index `j` of the run belongs to the entity at offset `i + j`. Components of tombstone
+		 * entities are not alive and must be skipped. */
+		[[nodiscard]] virtual any_span get_any_span(size_type i) noexcept = 0;
+		/** @copydoc get_any_span */
+		[[nodiscard]] virtual const_any_span get_any_span(size_type i) const noexcept = 0;
+
+		/** Invokes the functor for every run of components of the set. See `get_any_span`.
+		 * @param f Functor invoked with the offset of the first component & the run itself. */
+		template<std::invocable<size_type, any_span> F>
+		void for_each_span(F &&f)
+		{
+			for (size_type i = 0, n = size(); i < n;)
+			{
+				const auto span = get_any_span(i);
+				std::invoke(f, i, span);
+				i += span.size;
+			}
+		}
+		/** @copydoc for_each_span */
+		template<std::invocable<size_type, const_any_span> F>
+		void for_each_span(F &&f) const
+		{
+			for (size_type i = 0, n = size(); i < n;)
+			{
+				const auto span = get_any_span(i);
+				std::invoke(f, i, span);
+				i += span.size;
+			}
+		}
+
+		/** Returns a scoped guard declaring shared (read-only) access to the set. See `component_access_guard`.
+		 * @note Access conflicts are only checked in debug builds. */
+		[[nodiscard]] component_read_guard read_access() const noexcept { return component_read_guard{m_access}; }
+		/** Returns a scoped guard declaring exclusive (write) access to the set. See `component_access_guard`.
+		 * @note Access conflicts are only checked in debug builds. */
+		[[nodiscard]] component_write_guard write_access() noexcept { return component_write_guard{m_access}; }
+
 		/** Rebinds component set to use new world instance. */
 		constexpr void rebind(entity_world &world) noexcept { m_world = &world; }
 
@@ -187,27 +266,28 @@ namespace sek
 		/** Locks component for the specified entity in place. Pointers to locked components are guaranteed to always
 		 * be stable, however locking a component prevents it from being sorted or owned by collections.
 		 * @return `true` if the component was previously unlocked, `false` otherwise.
-		 * @note Empty component types are never locked. */
-		virtual bool lock(entity_t entity) noexcept = 0;
+		 * @note Empty component types are never locked.
+		 * @throw std::bad_alloc If the component requires relocation and allocation failed (see `component_traits`). */
+		virtual bool lock(entity_t entity) = 0;
 		/** @copydoc lock */
-		virtual bool lock(const_iterator which) noexcept = 0;
+		virtual bool lock(const_iterator which) = 0;
 		/** Unlocks a locked component. See `lock`.
 		 * @return `true` if the component was previously locked, `false` otherwise.
 		 * @note Empty component types are never locked. */
-		virtual bool unlock(entity_t entity) noexcept = 0;
+		virtual bool unlock(entity_t entity) = 0;
 		/** @copydoc unlock */
-		virtual bool unlock(const_iterator which) noexcept = 0;
+		virtual bool unlock(const_iterator which) = 0;
 
 		/** Enables component for the specified entity.
 		 * @return `true` if the component was previously disabled, `false` otherwise. */
-		virtual bool enable(entity_t entity) const noexcept = 0;
+		virtual bool enable(entity_t entity) noexcept = 0;
 		/** @copydoc enable */
-		virtual bool enable(const_iterator which) const noexcept = 0;
+		virtual bool enable(const_iterator which) noexcept = 0;
 		/** Disables component for the specified entity.
 		 * @return `true` if the component was previously enabled, `false` otherwise. */
-		virtual bool disable(entity_t entity) const noexcept = 0;
+		virtual bool disable(entity_t entity) noexcept = 0;
 		/** @copydoc disable */
-		virtual bool disable(const_iterator which) const noexcept = 0;
+		virtual bool disable(const_iterator which) noexcept = 0;
 
 		/** @brief Replaces component of the specified entity with a new value.
 		 * @param entity Entity whose component to replace.
@@ -282,6 +362,23 @@ namespace sek
 		 * or disabled (`true` if enabled, `false` if disabled). */
 		[[nodiscard]] constexpr event_proxy<locked_event_type> on_enable() noexcept { return {m_enable}; }
 
+		/** Returns event proxy for the deferred component creation event.
+		 * Unlike `on_create`, listeners of this event are invoked by `entity_world::flush_events`. */
+		[[nodiscard]] constexpr event_proxy<create_event_type> on_create(deferred_t) noexcept { return {m_deferred_create}; }
+		/** Returns event proxy for the deferred component modification event.
+		 * Unlike `on_modify`, listeners of this event are invoked by `entity_world::flush_events`. */
+		[[nodiscard]] constexpr event_proxy<modify_event_type> on_modify(deferred_t) noexcept { return {m_deferred_modify}; }
+		/** Returns event proxy for the deferred component removal event.
+		 * Unlike `on_remove`, listeners of this event are invoked by `entity_world::flush_events`.
+		 * @note Deferred listeners are invoked after the component was destroyed. */
+		[[nodiscard]] constexpr event_proxy<remove_event_type> on_remove(deferred_t) noexcept { return {m_deferred_remove}; }
+		/** Returns event proxy for the deferred component lock event.
+		 * Unlike `on_lock`, listeners of this event are invoked by `entity_world::flush_events`. */
+		[[nodiscard]] constexpr event_proxy<locked_event_type> on_lock(deferred_t) noexcept { return {m_deferred_lock}; }
+		/** Returns event proxy for the deferred component enable event.
+		 * Unlike `on_enable`, listeners of this event are invoked by `entity_world::flush_events`. */
+		[[nodiscard]] constexpr event_proxy<enabled_event_type> on_enable(deferred_t) noexcept { return {m_deferred_enable}; }
+
 	protected:
 		constexpr void swap(generic_component_set &other) noexcept
 		{
@@ -294,29 +391,94 @@ namespace sek
 			swap(m_remove, other.m_remove);
 			swap(m_lock, other.m_lock);
 			swap(m_enable, other.m_enable);
+			swap(m_deferred_create, other.m_deferred_create);
+			swap(m_deferred_modify, other.m_deferred_modify);
+			swap(m_deferred_remove, other.m_deferred_remove);
+			swap(m_deferred_lock, other.m_deferred_lock);
+			swap(m_deferred_enable, other.m_deferred_enable);
+			swap(m_queue, other.m_queue);
 			swap(m_type, other.m_type);
 		}
 
+		using base_set::clear_silent;
 		using base_set::erase_;
 		using base_set::fixed_erase_;
 		using base_set::insert_;
 		using base_set::move_;
 		using base_set::push_back_;
+		using base_set::remap;
 		using base_set::swap_;
 
+		/* Replaces entities of the set using a remap table. See `entity_world::defragment`. */
+		virtual void remap_(const entity_remap &table) = 0;
+
 	protected:
-		constexpr void dispatch_create(entity_t e) { m_create(world(), e); }
-		constexpr void dispatch_modify(entity_t e) { m_modify(world(), e); }
+		constexpr void assert_writable() const noexcept { m_access.assert_writable(); }
+		/* Replaces entities of pending deferred events using a remap table. */
+		void remap_events(const entity_remap &table) { m_queue.remap(table); }
+		/* Drops all pending deferred events. */
+		void clear_events() noexcept { m_queue.clear(); }
+
+		/* Events are only invoked if they have listeners, so that sets of unobserved types skip dispatch via a
+		 * single branch. */
+		constexpr void dispatch_create(entity_t e)
+		{
+			if (!m_create.empty()) m_create(world(), e);
+			defer(m_deferred_create, e, detail::event_kind::create);
+		}
+		constexpr void dispatch_modify(entity_t e)
+		{
+			if (!m_modify.empty()) m_modify(world(), e);
+			defer(m_deferred_modify, e, detail::event_kind::modify);
+		}
 		constexpr void dispatch_create(size_type idx) { dispatch_create(at(idx)); }
 		constexpr void dispatch_modify(size_type idx) { dispatch_modify(at(idx)); }
-		constexpr void dispatch_remove(size_type idx) { m_remove(world(), at(idx)); }
+		constexpr void dispatch_remove(size_type idx)
+		{
+			const auto e = at(idx);
+			if (!m_remove.empty()) m_remove(world(), e);
+			defer(m_deferred_remove, e, detail::event_kind::remove);
+		}
 
-		constexpr void dispatch_lock(entity_t e, bool value) { m_lock(world(), e, value); }
-		constexpr void dispatch_enable(entity_t e, bool value) { m_enable(world(), e, value); }
+		constexpr void dispatch_lock(entity_t e, bool value)
+		{
+			if (!m_lock.empty()) m_lock(world(), e, value);
+			defer(m_deferred_lock, e, detail::event_kind::lock, value);
+		}
+		constexpr void dispatch_enable(entity_t e, bool value)
+		{
+			if (!m_enable.empty()) m_enable(world(), e, value);
+			defer(m_deferred_enable, e, detail::event_kind::enable, value);
+		}
 		constexpr void dispatch_lock(size_type idx, bool value) { dispatch_lock(at(idx), value); }
 		constexpr void dispatch_enable(size_type idx, bool value) { dispatch_enable(at(idx), value); }
 
 	private:
+		template<typename E>
+		constexpr void defer(const E &event, entity_t e, detail::event_kind kind, bool value = false)
+		{
+			/* Only record events that have deferred listeners. */
+			if (!event.empty()) [[unlikely]]
+				m_queue.push({e, kind, value});
+		}
+
+		/* Delivers deferred events recorded since the last flush. */
+		void flush_events()
+		{
+			m_queue.flush(
+				[this](const detail::deferred_event &event)
+				{
+					switch (event.kind)
+					{
+						case detail::event_kind::create: m_deferred_create(world(), event.entity); break;
+						case detail::event_kind::modify: m_deferred_modify(world(), event.entity); break;
+						case detail::event_kind::remove: m_deferred_remove(world(), event.entity); break;
+						case detail::event_kind::lock: m_deferred_lock(world(), event.entity, event.value); break;
+						case detail::event_kind::enable: m_deferred_enable(world(), event.entity, event.value); break;
+					}
+				});
+		}
+
 		entity_world *m_world;
 
 		create_event_type m_create;
@@ -326,11 +488,145 @@ namespace sek
 		locked_event_type m_lock;
 		locked_event_type m_enable;
 
+		create_event_type m_deferred_create;
+		modify_event_type m_deferred_modify;
+		remove_event_type m_deferred_remove;
+		locked_event_type m_deferred_lock;
+		enabled_event_type m_deferred_enable;
+		detail::event_queue m_queue; /* Events recorded for deferred listeners. */
+		mutable detail::access_tracker m_access;
+
 		type_info m_type;
 	};
 
 	namespace detail
 	{
+		/* Lock & enable flags of components are stored in separate dense bit arrays (one bit per component),
+		 * which allows flag-only scans to not touch component memory and to process a word of flags at a time. */
+		class component_flags
+		{
+		public:
+			using size_type = std::size_t;
+
+			constexpr static size_type npos = std::numeric_limits<size_type>::max();
+
+		private:
+			using words_data = std::vector<size_type>;
+
+			constexpr static size_type word_bits = sizeof(size_type) * 8;
+
+			[[nodiscard]] constexpr static size_type word_idx(size_type i) noexcept { return i / word_bits; }
+			[[nodiscard]] constexpr static size_type bit_mask(size_type i) noexcept
+			{
+				return size_type{1} << (i % word_bits);
+			}
+
+			[[nodiscard]] constexpr static bool get_bit(const words_data &words, size_type i) noexcept
+			{
+				return words[word_idx(i)] & bit_mask(i);
+			}
+			constexpr static bool set_bit(words_data &words, size_type i, bool value) noexcept
+			{
+				auto &word = words[word_idx(i)];
+				const auto mask = bit_mask(i);
+				const auto old_value = word & mask;
+				word = value ? (word | mask) : (word & ~mask);
+				return old_value;
+			}
+
+		public:
+			constexpr component_flags() = default;
+
+			/** Makes sure flags for `n` components are available. */
+			constexpr void reserve(size_type n)
+			{
+				if (const auto words = word_idx(n + word_bits - 1); words > m_enabled.size())
+				{
+					m_locked.resize(words, 0);
+					m_enabled.resize(words, 0);
+				}
+			}
+			constexpr void clear() noexcept
+			{
+				std::fill(m_locked.begin(), m_locked.end(), 0);
+				std::fill(m_enabled.begin(), m_enabled.end(), 0);
+			}
+
+			[[nodiscard]] constexpr bool is_locked(size_type i) const noexcept { return get_bit(m_locked, i); }
+			constexpr bool set_locked(size_type i, bool value) noexcept { return set_bit(m_locked, i, value); }
+			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return get_bit(m_enabled, i); }
+			constexpr bool set_enabled(size_type i, bool value) noexcept { return set_bit(m_enabled, i, value); }
+
+			/** Initializes flags of a newly created component (unlocked & enabled). */
+			constexpr void reset(size_type i) noexcept
+			{
+				set_bit(m_locked, i, false);
+				set_bit(m_enabled, i, true);
+			}
+			/** Moves flags of component `from` to component `to`. */
+			constexpr void move(size_type to, size_type from) noexcept
+			{
+				set_bit(m_locked, to, get_bit(m_locked, from));
+				set_bit(m_enabled, to, get_bit(m_enabled, from));
+			}
+			/** Swaps flags of components `a` and `b`. */
+			constexpr void swap(size_type a, size_type b) noexcept
+			{
+				const auto a_locked = get_bit(m_locked, a);
+				const auto a_enabled = get_bit(m_enabled, a);
+				set_bit(m_locked, a, get_bit(m_locked, b));
+				set_bit(m_enabled, a, get_bit(m_enabled, b));
+				set_bit(m_locked, b, a_locked);
+				set_bit(m_enabled, b, a_enabled);
+			}
+
+			/** Returns amount of enabled components within the range `[0, n)`. */
+			[[nodiscard]] constexpr size_type enabled_count(size_type n) const noexcept
+			{
+				size_type result = 0;
+				const auto last = word_idx(n);
+				for (size_type i = 0; i < last; ++i) result += static_cast<size_type>(std::popcount(m_enabled[i]));
+				if (const auto rem = n % word_bits; rem != 0)
+					result += static_cast<size_type>(std::popcount(m_enabled[last] & (bit_mask(rem) - 1)));
+				return result;
+			}
+			/** Returns index of the first enabled component within the range `[i, n)` or `n` if there is none. */
+			[[nodiscard]] constexpr size_type next_enabled(size_type i, size_type n) const noexcept
+			{
+				for (auto idx = word_idx(i), last = word_idx(n + word_bits - 1); i < n && idx < last;)
+				{
+					/* Mask out bits preceding `i` & skip the whole word if none are left. */
+					if (const auto word = m_enabled[idx] & ~(bit_mask(i) - 1); word != 0)
+						return std::min(idx * word_bits + static_cast<size_type>(std::countr_zero(word)), n);
+					i = ++idx * word_bits;
+				}
+				return n;
+			}
+			/** Returns index of the last enabled component within the range `[0, i]` or `npos` if there is none. */
+			[[nodiscard]] constexpr size_type prev_enabled(size_type i) const noexcept
+			{
+				for (auto idx = word_idx(i) + 1; idx-- != 0;)
+				{
+					/* Mask out bits following `i` & skip the whole word if none are left. */
+					const auto shift = word_bits - 1 - i % word_bits;
+					if (const auto word = (m_enabled[idx] << shift) >> shift; word != 0)
+						return idx * word_bits + word_bits - 1 - static_cast<size_type>(std::countl_zero(word));
+					i = idx * word_bits - 1;
+				}
+				return npos;
+			}
+
+			constexpr void swap(component_flags &other) noexcept
+			{
+				m_locked.swap(other.m_locked);
+				m_enabled.swap(other.m_enabled);
+			}
+
+		private:
+			words_data m_locked;
+			words_data m_enabled;
+		};
+
 		template<typename T>
 		class component_pool : ebo_base_helper<typename component_traits<T>::allocator_type>
 		{
@@ -348,43 +644,23 @@ namespace sek
 			using alloc_traits = std::allocator_traits<alloc_type>;
 			using alloc_base = ebo_base_helper<alloc_type>;
 
-			using pages_alloc = typename alloc_traits::template rebind_alloc<std::byte *>;
-			using pages_data = std::vector<std::byte *, pages_alloc>;
-
-			constexpr static size_type flag_bits = 2;
-			constexpr static size_type locked_bit = 1;
-			constexpr static size_type enabled_bit = 2;
-
-			[[nodiscard]] constexpr static size_type bitfield_size(size_type n) noexcept
-			{
-				/* Align the bitfield to be a multiple of component alignment or size, whichever is greater. */
-				constexpr auto align = std::max(alignof(T), sizeof(T));
-				n = n * flag_bits; /* There are `flag_bits` flags for each component. */
-				const auto bytes = (n / sizeof(std::byte) + !!(n % sizeof(std::byte)));
-				const auto rem = bytes % align;
-				return bytes - rem + (rem ? align : 0);
-			}
-			[[nodiscard]] constexpr static size_type page_bytes(size_type n) noexcept
-			{
-				/* A page is made up of a bitfield indicating locked and enabled components, followed by an array of components */
-				return bitfield_size(n) + n * sizeof(T);
-			}
-			[[nodiscard]] constexpr static T *page_data(std::byte *ptr) noexcept
-			{
-				return std::bit_cast<T *>(ptr + bitfield_size(page_size));
-			}
+			using pages_alloc = typename alloc_traits::template rebind_alloc<T *>;
+			using pages_data = std::vector<T *, pages_alloc>;
 
 		public:
 			component_pool(const component_pool &) = delete;
 			component_pool &operator=(const component_pool &) = delete;
 
 			constexpr component_pool() = default;
+			constexpr explicit component_pool(const alloc_type &alloc) : alloc_base(alloc), m_pages(pages_alloc{alloc})
+			{
+			}
 
 			// clang-format off
 			constexpr component_pool(component_pool &&other)
 				noexcept(sek::detail::nothrow_alloc_move_construct<alloc_type> &&
 						 std::is_nothrow_move_constructible_v<pages_data>)
-				: alloc_base(std::move(other)), m_pages(std::move(other.m_pages))
+				: alloc_base(std::move(other)), m_pages(std::move(other.m_pages)), m_flags(std::move(other.m_flags))
 			{
 				assert_alloc(other);
 			}
@@ -395,6 +671,7 @@ namespace sek
 				assert_alloc(other);
 				alloc_base::operator=(std::move(other));
 				m_pages = std::move(other.m_pages);
+				m_flags = std::move(other.m_flags);
 				return *this;
 			}
 			// clang-format on
@@ -404,6 +681,8 @@ namespace sek
 				for (auto page : m_pages) dealloc_page(page);
 			}
 
+			[[nodiscard]] constexpr const component_flags &flags() const noexcept { return m_flags; }
+
 			[[nodiscard]] constexpr T *component_ptr(size_type i) const noexcept
 			{
 				const auto idx = page_idx(i);
@@ -411,32 +690,32 @@ namespace sek
 
 				if (idx >= m_pages.size() || m_pages[idx] == nullptr) [[unlikely]]
 					return nullptr;
-				return page_data(m_pages[idx]) + off;
+				return m_pages[idx] + off;
 			}
 			[[nodiscard]] constexpr T &component_ref(size_type i) const noexcept
 			{
 				const auto idx = page_idx(i);
 				const auto off = page_off(i);
-				return page_data(m_pages[idx])[off];
-			}
-
-			[[nodiscard]] constexpr bool is_locked(size_type i) const noexcept { return get_flags(i, locked_bit); }
-			[[nodiscard]] constexpr bool set_locked(size_type i, bool value) noexcept
-			{
-				return set_flags(i, locked_bit, static_cast<size_type>(value) & locked_bit);
+				return m_pages[idx][off];
 			}
-			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return get_flags(i, enabled_bit); }
-			[[nodiscard]] constexpr bool set_enabled(size_type i, bool value) noexcept
+			/* Returns pointer to the component at `i` & the amount of components (up to `n`) following it within the page. */
+			[[nodiscard]] constexpr std::pair<T *, size_type> component_run(size_type i, size_type n) const noexcept
 			{
-				return set_flags(i, enabled_bit, (static_cast<size_type>(value) << 1) & enabled_bit);
+				return {std::addressof(component_ref(i)), std::min(n, page_size - page_off(i))};
 			}
 
+			[[nodiscard]] constexpr bool is_locked(size_type i) const noexcept { return m_flags.is_locked(i); }
+			constexpr bool set_locked(size_type i, bool value) noexcept { return m_flags.set_locked(i, value); }
+			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return m_flags.is_enabled(i); }
+			constexpr bool set_enabled(size_type i, bool value) noexcept { return m_flags.set_enabled(i, value); }
+
 			constexpr void reserve(size_type n)
 			{
 				const auto pages = page_idx(n) + 1;
 				if (pages > m_pages.size()) m_pages.resize(pages, nullptr);
 				for (size_type i = 0; i < pages; ++i)
 					if (m_pages[i] == nullptr) m_pages[i] = alloc_page();
+				m_flags.reserve(pages * page_size);
 			}
 
 			template<typename... Args>
@@ -451,13 +730,15 @@ namespace sek
 				SEK_ASSERT(!(is_locked(to) || is_locked(from)), "Cannot move locked components");
 
 				component_ref(to) = std::move(component_ref(from));
+				m_flags.move(to, from);
 			}
 			constexpr void swap_value(size_type a, size_type b)
 			{
-				SEK_ASSERT(!(is_locked(to) || is_locked(from)), "Cannot swap locked components");
+				SEK_ASSERT(!(is_locked(a) || is_locked(b)), "Cannot swap locked components");
 
 				using std::swap;
 				swap(component_ref(a), component_ref(b));
+				m_flags.swap(a, b);
 			}
 
 			constexpr void swap(component_pool &other) noexcept
@@ -465,29 +746,10 @@ namespace sek
 				sek::detail::alloc_assert_swap(alloc(), other.alloc());
 				sek::detail::alloc_swap(alloc(), other.alloc());
 				std::swap(m_pages, other.m_pages);
+				m_flags.swap(other.m_flags);
 			}
 
 		private:
-			[[nodiscard]] constexpr size_type get_flags(size_type i, size_type mask) const noexcept
-			{
-				const auto bitset = static_cast<const size_type *>(m_pages[page_idx(i)]);
-				const auto off = page_off(i) * flag_bits;
-				return bitset[off / sizeof(size_type)] & (mask << (off % sizeof(size_type)));
-			}
-			[[nodiscard]] constexpr size_type set_flags(size_type i, size_type mask, size_type value) noexcept
-			{
-				const auto bitset = static_cast<size_type *>(m_pages[page_idx(i)]);
-				const auto off = page_off(i) * flag_bits;
-				const auto word_off = off / sizeof(size_type);
-				const auto bit_off = off % sizeof(size_type);
-
-				mask = mask << bit_off;
-				auto &word = bitset[word_off];
-				const auto old_value = word & mask;
-				word = (word & ~mask) | (value << bit_off);
-				return old_value;
-			}
-
 			[[nodiscard]] constexpr auto &alloc() noexcept { return *alloc_base::get(); }
 			[[nodiscard]] constexpr auto &alloc() const noexcept { return *alloc_base::get(); }
 			constexpr void assert_alloc(const component_pool &other [[maybe_unused]])
@@ -496,16 +758,8 @@ namespace sek
 						   sek::detail::alloc_eq(alloc(), other.alloc()));
 			}
 
-			[[nodiscard]] constexpr std::byte *alloc_page()
-			{
-				constexpr auto total_size = page_bytes(page_size) / sizeof(T);
-				return static_cast<std::byte *>(alloc_traits::allocate(alloc(), total_size));
-			}
-			constexpr void dealloc_page(std::byte *page)
-			{
-				constexpr auto total_size = page_bytes(page_size) / sizeof(T);
-				alloc_traits::deallocate(alloc(), page, total_size);
-			}
+			[[nodiscard]] constexpr T *alloc_page() { return alloc_traits::allocate(alloc(), page_size); }
+			constexpr void dealloc_page(T *page) { alloc_traits::deallocate(alloc(), page, page_size); }
 
 			[[nodiscard]] constexpr T *alloc_entry(size_type i)
 			{
@@ -513,24 +767,23 @@ namespace sek
 				const auto off = page_off(i);
 
 				/* Make sure page list has enough space. */
-				if (const auto req = idx + 1; req > m_pages.size()) m_pages.resize(req, nullptr);
+				if (const auto req = idx + 1; req > m_pages.size())
+				{
+					m_pages.resize(req, nullptr);
+					m_flags.reserve(req * page_size);
+				}
 
 				/* Allocate the page if it is empty. */
 				auto &page = m_pages[idx];
 				if (page == nullptr) [[unlikely]]
 					page = alloc_page();
 
-				/* Initialize flags. */
-				const auto flag_off = off * flag_bits;
-				const auto word_off = flag_off / sizeof(size_type);
-				const auto bit_off = flag_off % sizeof(size_type);
-				const auto mask = (enabled_bit | locked_bit) << bit_off;
-				static_cast<size_type *>(page)[word_off] &= ~mask;
-
-				return page_data(page) + off;
+				m_flags.reset(i);
+				return page + off;
 			}
 
 			pages_data m_pages;
+			component_flags m_flags;
 		};
 
 		template<typename T>
@@ -538,47 +791,34 @@ namespace sek
 		template<empty_component T>
 		class component_pool<T> : ebo_base_helper<T>
 		{
-			constexpr static auto page_size = component_traits<T>::page_size;
-
-			[[nodiscard]] constexpr static auto page_idx(auto n) noexcept { return n / page_size; }
-			[[nodiscard]] constexpr static auto page_off(auto n) noexcept { return n % page_size; }
-
 		public:
 			using size_type = std::size_t;
 			using difference_type = std::ptrdiff_t;
 
 		private:
-			using pages_data = std::vector<size_type *>;
 			using value_base = ebo_base_helper<T>;
 
-			[[nodiscard]] constexpr static size_type bitfield_size(size_type n) noexcept
-			{
-				/* Align the bitfield to be a multiple of size_type. */
-				constexpr auto align = sizeof(size_type);
-				const auto bytes = (n / sizeof(std::byte) + !!(n % sizeof(std::byte)));
-				const auto rem = bytes % align;
-				return bytes - rem + (rem ? align : 0);
-			}
-
 		public:
 			component_pool(const component_pool &) = delete;
 			component_pool &operator=(const component_pool &) = delete;
 
 			constexpr component_pool() = default;
 
-			constexpr component_pool(component_pool &&other) noexcept(std::is_nothrow_move_constructible_v<pages_data>)
-				: value_base(std::move(other)), m_pages(std::move(other.m_pages))
+			constexpr component_pool(component_pool &&other) noexcept
+				: value_base(std::move(other)), m_flags(std::move(other.m_flags))
 			{
 			}
-			constexpr component_pool &operator=(component_pool &&other) noexcept(std::is_nothrow_move_assignable_v<pages_data>)
+			constexpr component_pool &operator=(component_pool &&other) noexcept
 			{
 				value_base::operator=(std::move(other));
-				m_pages = std::move(other.m_pages);
+				m_flags = std::move(other.m_flags);
 				return *this;
 			}
 
 			constexpr void release_pages() {}
 
+			[[nodiscard]] constexpr const component_flags &flags() const noexcept { return m_flags; }
+
 			[[nodiscard]] constexpr T *component_ptr(size_type) const noexcept
 			{
 				return const_cast<T *>(value_base::get());
@@ -587,31 +827,97 @@ namespace sek
 			{
 				return *const_cast<T *>(value_base::get());
 			}
+			[[nodiscard]] constexpr std::pair<T *, size_type> component_run(size_type i, size_type n) const noexcept
+			{
+				return {component_ptr(i), n};
+			}
 
-			constexpr void reserve(size_type) {}
+			constexpr void reserve(size_type n) { m_flags.reserve(n); }
 
 			[[nodiscard]] constexpr bool is_locked(size_type) const noexcept { return false; }
-			[[nodiscard]] constexpr bool set_locked(size_type, bool) noexcept { return false; }
+			constexpr bool set_locked(size_type, bool) noexcept { return false; }
+			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return m_flags.is_enabled(i); }
+			constexpr bool set_enabled(size_type i, bool value) noexcept { return m_flags.set_enabled(i, value); }
 
-			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept
+			template<typename... Args>
+			constexpr T &emplace(size_type i, Args &&...args)
 			{
-				const auto idx = page_idx(i);
-				const auto off = page_off(i);
-				const auto mask = 1 << (off % sizeof(size_type));
-				return m_pages[idx][off / sizeof(size_type)] & mask;
+				m_flags.reserve(i + 1);
+				m_flags.reset(i);
+				return *std::construct_at(component_ptr(i), std::forward<Args>(args)...);
 			}
-			[[nodiscard]] constexpr bool set_enabled(size_type i, bool value) noexcept
+			constexpr void erase(size_type i) { std::destroy_at(component_ptr(i)); }
+
+			constexpr void move_value(size_type to, size_type from) noexcept { m_flags.move(to, from); }
+			constexpr void swap_value(size_type a, size_type b) noexcept { m_flags.swap(a, b); }
+
+			constexpr void reset_frame() noexcept { m_flags.clear(); }
+
+			constexpr void swap(component_pool &other) noexcept { m_flags.swap(other.m_flags); }
+
+		private:
+			/* Tag components have no per-component storage besides their flags. */
+			component_flags m_flags;
+		};
+
+		template<typename T>
+		concept transient_component = std::is_trivially_destructible_v<T> &&
+									  requires { requires component_traits<T>::is_transient; };
+		template<transient_component T>
+			requires(!std::is_empty_v<T>)
+		class component_pool<T>
+		{
+			constexpr static auto page_size = component_traits<T>::page_size;
+
+			[[nodiscard]] constexpr static auto page_idx(auto n) noexcept { return n / page_size; }
+			[[nodiscard]] constexpr static auto page_off(auto n) noexcept { return n % page_size; }
+
+		public:
+			using size_type = std::size_t;
+			using difference_type = std::ptrdiff_t;
+
+		public:
+			component_pool(const component_pool &) = delete;
+			component_pool &operator=(const component_pool &) = delete;
+
+			constexpr component_pool() = default;
+			constexpr explicit component_pool(frame_arena &frames) noexcept : m_frames(&frames) {}
+			constexpr component_pool(component_pool &&) noexcept = default;
+			constexpr component_pool &operator=(component_pool &&) noexcept = default;
+
+			/* Pages are owned by the frame arena. */
+			constexpr void release_pages() {}
+
+			[[nodiscard]] constexpr const component_flags &flags() const noexcept { return m_flags; }
+
+			[[nodiscard]] constexpr T *component_ptr(size_type i) const noexcept
 			{
 				const auto idx = page_idx(i);
-				const auto off = page_off(i);
-				const auto word_off = off / sizeof(size_type);
-				const auto bit_off = off % sizeof(size_type);
-				const auto mask = 1 << bit_off;
-				auto &word = bitset[word_off];
+				if (idx >= m_pages.size() || m_pages[idx] == nullptr) [[unlikely]]
+					return nullptr;
+				return m_pages[idx] + page_off(i);
+			}
+			[[nodiscard]] constexpr T &component_ref(size_type i) const noexcept
+			{
+				return m_pages[page_idx(i)][page_off(i)];
+			}
+			[[nodiscard]] constexpr std::pair<T *, size_type> component_run(size_type i, size_type n) const noexcept
+			{
+				return {std::addressof(component_ref(i)), std::min(n, page_size - page_off(i))};
+			}
 
-				const auto old_value = word & mask;
-				word = (word & ~mask) | (static_cast<size_type>(value) << bit_off);
-				return old_value;
+			[[nodiscard]] constexpr bool is_locked(size_type i) const noexcept { return m_flags.is_locked(i); }
+			constexpr bool set_locked(size_type i, bool value) noexcept { return m_flags.set_locked(i, value); }
+			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return m_flags.is_enabled(i); }
+			constexpr bool set_enabled(size_type i, bool value) noexcept { return m_flags.set_enabled(i, value); }
+
+			constexpr void reserve(size_type n)
+			{
+				const auto pages = page_idx(n) + 1;
+				if (pages > m_pages.size()) m_pages.resize(pages, nullptr);
+				for (size_type i = 0; i < pages; ++i)
+					if (m_pages[i] == nullptr) m_pages[i] = alloc_page();
+				m_flags.reserve(pages * page_size);
 			}
 
 			template<typename... Args>
@@ -619,39 +925,279 @@ namespace sek
 			{
 				return *std::construct_at(alloc_entry(i), std::forward<Args>(args)...);
 			}
-			constexpr void erase(size_type i) { std::destroy_at(component_ptr(i)); }
+			/* Transient components are trivially destructible. */
+			constexpr void erase(size_type) noexcept {}
+
+			constexpr void move_value(size_type to, size_type from)
+			{
+				SEK_ASSERT(!(is_locked(to) || is_locked(from)), "Cannot move locked components");
 
-			constexpr void move_value(size_type, size_type) noexcept {}
-			constexpr void swap_value(size_type, size_type) noexcept {}
+				component_ref(to) = std::move(component_ref(from));
+				m_flags.move(to, from);
+			}
+			constexpr void swap_value(size_type a, size_type b)
+			{
+				SEK_ASSERT(!(is_locked(a) || is_locked(b)), "Cannot swap locked components");
 
-			constexpr void swap(component_pool &) noexcept {}
+				using std::swap;
+				swap(component_ref(a), component_ref(b));
+				m_flags.swap(a, b);
+			}
+
+			/** Drops all pages without destroying components. Pages are reclaimed by the frame arena. */
+			constexpr void reset_frame() noexcept
+			{
+				std::fill(m_pages.begin(), m_pages.end(), nullptr);
+				m_flags.clear();
+			}
+
+			constexpr void swap(component_pool &other) noexcept
+			{
+				m_pages.swap(other.m_pages);
+				m_flags.swap(other.m_flags);
+				std::swap(m_frames, other.m_frames);
+			}
 
 		private:
-			[[nodiscard]] constexpr size_type *alloc_page() { return new size_type[bitfield_size(page_size)]; }
-			constexpr void dealloc_page(size_type *page) { delete[] page; }
+			[[nodiscard]] T *alloc_page()
+			{
+				SEK_ASSERT(m_frames != nullptr, "Transient component pool is not bound to a frame arena");
+				return static_cast<T *>(m_frames->allocate(page_size * sizeof(T), alignof(T)));
+			}
 
 			[[nodiscard]] constexpr T *alloc_entry(size_type i)
 			{
 				const auto idx = page_idx(i);
-				const auto off = page_off(i);
-
-				/* Make sure page list has enough space. */
-				if (const auto req = idx + 1; req > m_pages.size()) m_pages.resize(req, nullptr);
+				if (const auto req = idx + 1; req > m_pages.size())
+				{
+					m_pages.resize(req, nullptr);
+					m_flags.reserve(req * page_size);
+				}
 
-				/* Allocate the page if it is empty. */
 				auto &page = m_pages[idx];
 				if (page == nullptr) [[unlikely]]
 					page = alloc_page();
 
-				/* Initialize enabled flag. */
-				const auto word_off = off / sizeof(size_type);
-				const auto bit_off = off & sizeof(size_type);
-				page[word_off] &= ~(1 << bit_off);
+				m_flags.reset(i);
+				return page + page_off(i);
+			}
+
+			std::vector<T *> m_pages;
+			component_flags m_flags;
+			frame_arena *m_frames = nullptr; /* Frame arena of the parent world. */
+		};
+
+		template<typename T>
+		concept contiguous_component = !std::is_empty_v<T> && !transient_component<T> && std::is_trivially_copyable_v<T> &&
+									   requires { requires component_traits<T>::is_contiguous; };
+		template<contiguous_component T>
+		class component_pool<T> : ebo_base_helper<typename component_traits<T>::allocator_type>
+		{
+			constexpr static std::size_t min_capacity = 16;
+
+		public:
+			using size_type = std::size_t;
+			using difference_type = std::ptrdiff_t;
+
+		private:
+			using alloc_type = typename component_traits<T>::allocator_type;
+			using alloc_traits = std::allocator_traits<alloc_type>;
+			using alloc_base = ebo_base_helper<alloc_type>;
+
+			using stable_data = dense_map<size_type, T *>;
+
+		public:
+			component_pool(const component_pool &) = delete;
+			component_pool &operator=(const component_pool &) = delete;
+
+			constexpr component_pool() = default;
+			constexpr explicit component_pool(const alloc_type &alloc) : alloc_base(alloc) {}
 
-				return component_ptr(i);
+			// clang-format off
+			constexpr component_pool(component_pool &&other)
+				noexcept(sek::detail::nothrow_alloc_move_construct<alloc_type> &&
+						 std::is_nothrow_move_constructible_v<stable_data>)
+				: alloc_base(std::move(other)),
+				  m_data(std::exchange(other.m_data, nullptr)),
+				  m_capacity(std::exchange(other.m_capacity, 0)),
+				  m_flags(std::move(other.m_flags)),
+				  m_stable(std::move(other.m_stable))
+			{
+				assert_alloc(other);
+			}
+			constexpr component_pool &operator=(component_pool &&other)
+				noexcept(sek::detail::nothrow_alloc_move_assign<alloc_type> &&
+				         std::is_nothrow_move_assignable_v<stable_data>)
+			{
+				assert_alloc(other);
+				release_pages();
+				alloc_base::operator=(std::move(other));
+				m_data = std::exchange(other.m_data, nullptr);
+				m_capacity = std::exchange(other.m_capacity, 0);
+				m_flags = std::move(other.m_flags);
+				m_stable = std::move(other.m_stable);
+				return *this;
 			}
+			// clang-format on
 
-			pages_data m_pages;
+			constexpr void release_pages()
+			{
+				for (auto &node : m_stable) alloc_traits::deallocate(alloc(), node.second, 1);
+				m_stable.clear();
+
+				if (m_data != nullptr) alloc_traits::deallocate(alloc(), m_data, m_capacity);
+				m_data = nullptr;
+				m_capacity = 0;
+			}
+
+			[[nodiscard]] constexpr const component_flags &flags() const noexcept { return m_flags; }
+
+			/** Returns pointer to the component buffer. Components are laid out contiguously within the buffer,
+			 * thus (unless `has_locked` is `true`) they can be iterated by simple pointer increment. */
+			[[nodiscard]] constexpr T *data() const noexcept { return m_data; }
+			/** Checks if any components were relocated to the side table by being locked. */
+			[[nodiscard]] constexpr bool has_locked() const noexcept { return !m_stable.empty(); }
+
+			[[nodiscard]] constexpr T *component_ptr(size_type i) const noexcept
+			{
+				if (i >= m_capacity) [[unlikely]]
+					return nullptr;
+				return std::addressof(component_ref(i));
+			}
+			[[nodiscard]] constexpr T &component_ref(size_type i) const noexcept
+			{
+				/* Locked components live in the side table. Only check it if any components are locked,
+				 * so that the common case is a single predictable branch. */
+				if (has_locked() && is_locked(i)) [[unlikely]]
+					return *m_stable.find(i)->second;
+				return m_data[i];
+			}
+			[[nodiscard]] constexpr std::pair<T *, size_type> component_run(size_type i, size_type n) const noexcept
+			{
+				if (!has_locked()) [[likely]]
+					return {m_data + i, n};
+
+				/* Locked components are not part of the buffer, thus runs stop at locked components. */
+				if (is_locked(i)) return {m_stable.find(i)->second, 1};
+				size_type count = 1;
+				while (count < n && !is_locked(i + count)) ++count;
+				return {m_data + i, count};
+			}
+
+			[[nodiscard]] constexpr bool is_locked(size_type i) const noexcept { return m_flags.is_locked(i); }
+			constexpr bool set_locked(size_type i, bool value)
+			{
+				const auto old_value = is_locked(i);
+				if (value && !old_value)
+				{
+					/* Relocate the component to a stable node, since the buffer may be re-allocated.
+					 * The flag is only set once the node is in place, so that a failed allocation leaves the
+					 * component unlocked. */
+					const auto node = alloc_traits::allocate(alloc(), 1);
+					try
+					{
+						m_stable.emplace(i, node);
+					}
+					catch (...)
+					{
+						alloc_traits::deallocate(alloc(), node, 1);
+						throw;
+					}
+					std::memcpy(node, m_data + i, sizeof(T));
+				}
+				else if (!value && old_value)
+				{
+					/* Move the component back to the buffer & release the node. */
+					const auto node = m_stable.find(i);
+					std::memcpy(m_data + i, node->second, sizeof(T));
+					alloc_traits::deallocate(alloc(), node->second, 1);
+					m_stable.erase(node);
+				}
+				return m_flags.set_locked(i, value);
+			}
+			[[nodiscard]] constexpr bool is_enabled(size_type i) const noexcept { return m_flags.is_enabled(i); }
+			constexpr bool set_enabled(size_type i, bool value) noexcept { return m_flags.set_enabled(i, value); }
+
+			constexpr void reserve(size_type n)
+			{
+				if (n > m_capacity) grow(n);
+			}
+
+			template<typename... Args>
+			constexpr T &emplace(size_type i, Args &&...args)
+			{
+				if (i >= m_capacity) [[unlikely]]
+					grow(std::max({i + 1, m_capacity * 2, min_capacity}));
+
+				m_flags.reset(i);
+				return *std::construct_at(m_data + i, std::forward<Args>(args)...);
+			}
+			constexpr void erase(size_type i)
+			{
+				if (has_locked() && is_locked(i)) [[unlikely]]
+				{
+					const auto node = m_stable.find(i);
+					alloc_traits::deallocate(alloc(), node->second, 1);
+					m_stable.erase(node);
+					m_flags.set_locked(i, false);
+				}
+			}
+
+			constexpr void move_value(size_type to, size_type from)
+			{
+				SEK_ASSERT(!(is_locked(to) || is_locked(from)), "Cannot move locked components");
+
+				m_data[to] = m_data[from];
+				m_flags.move(to, from);
+			}
+			constexpr void swap_value(size_type a, size_type b)
+			{
+				SEK_ASSERT(!(is_locked(a) || is_locked(b)), "Cannot swap locked components");
+
+				std::swap(m_data[a], m_data[b]);
+				m_flags.swap(a, b);
+			}
+
+			constexpr void swap(component_pool &other) noexcept
+			{
+				sek::detail::alloc_assert_swap(alloc(), other.alloc());
+				sek::detail::alloc_swap(alloc(), other.alloc());
+
+				using std::swap;
+				swap(m_data, other.m_data);
+				swap(m_capacity, other.m_capacity);
+				swap(m_stable, other.m_stable);
+				m_flags.swap(other.m_flags);
+			}
+
+		private:
+			[[nodiscard]] constexpr auto &alloc() noexcept { return *alloc_base::get(); }
+			[[nodiscard]] constexpr auto &alloc() const noexcept { return *alloc_base::get(); }
+			constexpr void assert_alloc(const component_pool &other [[maybe_unused]])
+			{
+				SEK_ASSERT(alloc_traits::propagate_on_container_move_assignment::value ||
+						   sek::detail::alloc_eq(alloc(), other.alloc()));
+			}
+
+			constexpr void grow(size_type n)
+			{
+				/* Components are trivially copyable, thus the buffer can be relocated via `memcpy`. */
+				const auto new_data = alloc_traits::allocate(alloc(), n);
+				if (m_data != nullptr)
+				{
+					std::memcpy(new_data, m_data, m_capacity * sizeof(T));
+					alloc_traits::deallocate(alloc(), m_data, m_capacity);
+				}
+				m_data = new_data;
+				m_capacity = n;
+				m_flags.reserve(n);
+			}
+
+			T *m_data = nullptr;
+			size_type m_capacity = 0;
+
+			component_flags m_flags;
+			stable_data m_stable; /* Side table of locked components. */
 		};
 	}	 // namespace detail
 
@@ -663,6 +1209,9 @@ namespace sek
 		using base_t = generic_component_set;
 		using base_iter = typename base_t::iterator;
 
+		constexpr static bool is_tag = std::is_empty_v<T>;
+		constexpr static bool is_keyed = detail::keyed_component<T>;
+
 	public:
 		typedef typename base_t::create_event_type create_event_type;
 		typedef typename base_t::modify_event_type modify_event_type;
@@ -847,9 +1396,12 @@ namespace sek
 		component_set &operator=(const component_set &) = delete;
 
 		/** Initializes component storage for the specified world. */
-		constexpr component_set(entity_world &world) : base_t(type_info::get<T>(), world) {}
+		constexpr component_set(entity_world &world) : base_t(type_info::get<T>(), world), m_pool(make_pool(world))
+		{
+		}
 		/** Initializes component storage for the specified world and reserves `n` components. */
-		constexpr component_set(entity_world &world, size_type n) : base_t(type_info::get<T>(), world, n)
+		constexpr component_set(entity_world &world, size_type n)
+			: base_t(type_info::get<T>(), world, n), m_pool(make_pool(world))
 		{
 			reserve_impl(n);
 		}
@@ -939,6 +1491,32 @@ namespace sek
 		{
 			return is_enabled(offset(which));
 		}
+		/** Returns reference to the lock & enable flags of the set's components (indexed by entity offset). */
+		[[nodiscard]] constexpr const detail::component_flags &flags() const noexcept { return m_pool.flags(); }
+
+		/** Removes all components of the set at the end of a frame, without destroying them or dispatching
+		 * removal events. Storage of transient components is reclaimed by the frame arena of the parent world.
+		 * Deferred events recorded for the removed components are dropped.
+		 * @note Resetting is `O(n)`, since sparse entries of all entities of the set are cleared.
+		 * @note Only available for transient component types (see `component_traits`). */
+		constexpr void reset_frame() noexcept
+			requires detail::transient_component<T>
+		{
+			base_t::clear_silent();
+			m_pool.reset_frame();
+			m_index.clear();
+			clear_events();
+		}
+
+		/** Returns the entity who's component has the specified unique key, or a tombstone if no such entity exists.
+		 * Lookup is `O(1)` via the unique key index of the set.
+		 * @note Only available for component types with a unique key (see `component_traits`). */
+		template<typename K>
+		[[nodiscard]] constexpr entity_t find_by(const K &key) const noexcept
+			requires is_keyed
+		{
+			return m_index.find(key);
+		}
 
 		/** Returns reference to the component of an entity at the specified offset . */
 		[[nodiscard]] constexpr auto &get(size_type i) noexcept { return component_ref(i); }
@@ -963,6 +1541,21 @@ namespace sek
 		/** @copydoc base_t::get_any */
 		[[nodiscard]] any_ref get_any(entity_t entity) const noexcept final { return get_any(offset(entity)); }
 
+		/** @copydoc base_t::get_any_span */
+		[[nodiscard]] any_span get_any_span(size_type i) noexcept final
+		{
+			SEK_ASSERT(i < size());
+			const auto [data, n] = m_pool.component_run(i, size() - i);
+			return {type(), data, stride(), n};
+		}
+		/** @copydoc base_t::get_any_span */
+		[[nodiscard]] const_any_span get_any_span(size_type i) const noexcept final
+		{
+			SEK_ASSERT(i < size());
+			const auto [data, n] = m_pool.component_run(i, size() - i);
+			return {type(), data, stride(), n};
+		}
+
 		/** Reserves space for `n` entities and components. */
 		constexpr void reserve(size_type n)
 		{
@@ -980,33 +1573,28 @@ namespace sek
 		/** Locks component for the specified entity in place. Pointers to locked components are guaranteed to always
 		 * be stable, however locking a component prevents it from being sorted or owned by collections.
 		 * @return `true` if the component was previously unlocked, `false` otherwise.
-		 * @note Empty component types are never locked. */
-		constexpr bool lock(entity_t entity) noexcept final { return set_locked(offset(entity), entity, true); }
+		 * @note Empty component types are never locked.
+		 * @throw std::bad_alloc If the component requires relocation and allocation failed (see `component_traits`). */
+		constexpr bool lock(entity_t entity) final { return set_locked(offset(entity), entity, true); }
 		/** @copydoc lock */
-		constexpr bool lock(const_iterator which) noexcept { return set_locked(offset(which), *which, true); }
+		constexpr bool lock(const_iterator which) { return set_locked(offset(which), *which, true); }
 		/** Unlocks a locked component. See `lock`.
 		 * @return `true` if the component was previously locked, `false` otherwise.
 		 * @note Empty component types are never locked. */
-		constexpr bool unlock(entity_t entity) noexcept final { return set_locked(offset(entity), entity, false); }
+		constexpr bool unlock(entity_t entity) final { return set_locked(offset(entity), entity, false); }
 		/** @copydoc unlock */
-		constexpr bool unlock(const_iterator which) noexcept { return set_locked(offset(which), *which, false); }
+		constexpr bool unlock(const_iterator which) { return set_locked(offset(which), *which, false); }
 
 		/** Enables component for the specified entity.
 		 * @return `true` if the component was previously disabled, `false` otherwise. */
-		constexpr bool enable(entity_t entity) const noexcept final
-		{
-			return set_enabled(offset(entity), entity, true);
-		}
+		constexpr bool enable(entity_t entity) noexcept final { return set_enabled(offset(entity), entity, true); }
 		/** @copydoc enable */
-		constexpr bool enable(const_iterator which) const noexcept { return set_enabled(offset(entity), *which, true); }
+		constexpr bool enable(const_iterator which) noexcept { return set_enabled(offset(which), *which, true); }
 		/** Disables component for the specified entity.
 		 * @return `true` if the component was previously enabled, `false` otherwise. */
-		constexpr bool disable(entity_t entity) const noexcept { return set_enabled(offset(entity), entity, false); }
+		constexpr bool disable(entity_t entity) noexcept final { return set_enabled(offset(entity), entity, false); }
 		/** @copydoc disable */
-		constexpr bool disable(const_iterator which) const noexcept
-		{
-			return set_enabled(offset(entity), *which, false);
-		}
+		constexpr bool disable(const_iterator which) noexcept { return set_enabled(offset(which), *which, false); }
 
 		// clang-format off
 		/** @brief Replaces component of the specified entity with an in-place constructed instance.
@@ -1354,41 +1942,131 @@ namespace sek
 		{
 			base_t::swap(other);
 			m_pool.swap(other.m_pool);
+			m_index.swap(other.m_index);
 		}
 		friend constexpr void swap(component_set &a, component_set &b) noexcept { a.swap(b); }
 
 	private:
+		[[nodiscard]] constexpr static std::size_t stride() noexcept { return is_tag ? 0 : sizeof(T); }
+
 		[[nodiscard]] constexpr auto to_iterator(size_type i) noexcept { return iterator{this, i + 1}; }
 		[[nodiscard]] constexpr auto to_iterator(size_type i) const noexcept { return const_iterator{this, i + 1}; }
+		[[nodiscard]] constexpr static pool_t make_pool(entity_world &world)
+		{
+			/* Allocators that can be bound to a world (ex. `page_allocator`) are initialized from the parent world. */
+			using alloc_t = typename component_traits<T>::allocator_type;
+			if constexpr (!is_tag && detail::transient_component<T>)
+				return pool_t{detail::world_frame_arena(world)};
+			else if constexpr (!is_tag && std::constructible_from<alloc_t, entity_world &>)
+				return pool_t{alloc_t{world}};
+			else
+				return pool_t{};
+		}
+
 		[[nodiscard]] constexpr auto &entity_ref(size_type i) noexcept { return base_t::at(i); }
 		[[nodiscard]] constexpr auto &entity_ref(size_type i) const noexcept { return base_t::at(i); }
 		[[nodiscard]] constexpr auto &component_ref(size_type i) noexcept { return m_pool.component_ref(i); }
 		[[nodiscard]] constexpr auto &component_ref(size_type i) const noexcept { return m_pool.component_ref(i); }
 
+		/* Returns `false` if the key of the component is already used by another component. */
+		constexpr bool index_insert(size_type idx)
+		{
+			if constexpr (is_keyed)
+				return m_index.insert(component_traits<T>::unique_key(std::as_const(component_ref(idx))), at(idx));
+			else
+				return true;
+		}
+		constexpr void index_erase(size_type idx)
+		{
+			/* Components with a duplicate key are not indexed, thus only erase the key if it belongs to the entity. */
+			if constexpr (is_keyed)
+				m_index.erase(component_traits<T>::unique_key(std::as_const(component_ref(idx))), at(idx));
+		}
+		/* Returns `true` if the key of `value` is not used by components of other entities. */
+		[[nodiscard]] constexpr bool index_available(const T &value, size_type idx) const noexcept
+		{
+			if constexpr (is_keyed)
+			{
+				const auto owner = m_index.find(component_traits<T>::unique_key(value));
+				return owner.is_tombstone() || owner == at(idx);
+			}
+			else
+				return true;
+		}
+		[[noreturn]] static void duplicate_key() { throw std::invalid_argument("Component keys must be unique"); }
+
+		constexpr static void reassign(T &ref, T &&value)
+		{
+			if constexpr (std::is_move_assignable_v<T>)
+				ref = std::move(value);
+			else
+			{
+				std::destroy_at(std::addressof(ref));
+				std::construct_at(std::addressof(ref), std::move(value));
+			}
+		}
+
 		constexpr void reserve_impl(size_type n)
 		{
 			if (n != 0) [[likely]]
 				m_pool.reserve(n);
 		}
 
-		constexpr bool set_locked(size_type idx, entity_t e, bool value) noexcept
+		constexpr bool set_locked(size_type idx, entity_t e, bool value)
 		{
-			dispatch_lock(e, value);
-			return m_pool.set_locked(idx, value);
+			/* Dispatch only after the flag has changed, so that listeners observe the new state. */
+			const auto old_value = m_pool.set_locked(idx, value);
+			if (old_value != value) dispatch_lock(e, value);
+			return old_value;
 		}
 		[[nodiscard]] constexpr bool is_locked(size_type idx) const noexcept { return m_pool.is_locked(idx); }
 
 		constexpr bool set_enabled(size_type idx, entity_t e, bool value) noexcept
 		{
-			dispatch_enable(e, value);
-			return m_pool.set_enabled(idx, value);
+			const auto old_value = m_pool.set_enabled(idx, value);
+			if (old_value != value) dispatch_enable(e, value);
+			return old_value;
 		}
 		[[nodiscard]] constexpr bool is_enabled(size_type idx) const noexcept { return m_pool.is_enabled(idx); }
 
 		template<typename F>
 		constexpr size_type apply_impl(size_type idx, entity_t e, F &&f)
 		{
-			std::invoke(std::forward<F>(f), e, component_ref(idx));
+			base_t::assert_writable();
+
+			auto &ref = component_ref(idx);
+			if constexpr (is_keyed && std::is_copy_constructible_v<T>)
+			{
+				/* Keys may be changed by the functor, thus re-index the component. If the functor throws or the new key
+				 * is used by another component, the old value is restored & stays indexed under the old key. */
+				T old_value = std::as_const(ref);
+				index_erase(idx);
+				try
+				{
+					std::invoke(std::forward<F>(f), e, ref);
+				}
+				catch (...)
+				{
+					reassign(ref, std::move(old_value));
+					index_insert(idx);
+					throw;
+				}
+				if (!index_insert(idx)) [[unlikely]]
+				{
+					reassign(ref, std::move(old_value));
+					index_insert(idx);
+					duplicate_key();
+				}
+			}
+			else
+			{
+				/* Non-copyable components can not be restored, thus are left out of the index on a duplicate key. */
+				index_erase(idx);
+				std::invoke(std::forward<F>(f), e, ref);
+				if (!index_insert(idx)) [[unlikely]]
+					duplicate_key();
+			}
+
 			dispatch_modify(e);
 			return idx;
 		}
@@ -1396,22 +2074,49 @@ namespace sek
 		template<typename... Args>
 		constexpr size_type replace_impl(size_type idx, Args &&...args)
 		{
+			base_t::assert_writable();
+
 			auto &ref = component_ref(idx);
-			if constexpr (std::is_move_assignable_v<T>)
+			if constexpr (is_keyed)
+			{
+				/* Construct the new value first, so that a duplicate key leaves the component unchanged & indexed. */
+				T value{std::forward<Args>(args)...};
+				if (!index_available(value, idx)) [[unlikely]]
+					duplicate_key();
+
+				index_erase(idx);
+				reassign(ref, std::move(value));
+				index_insert(idx);
+			}
+			else if constexpr (std::is_move_assignable_v<T>)
 				ref = T{std::forward<Args>(args)...};
 			else
 			{
 				std::destroy_at(std::addressof(ref));
 				std::construct_at(std::addressof(ref), std::forward<Args>(args)...);
 			}
+
 			dispatch_modify(idx);
 			return idx;
 		}
 		template<typename U>
 		constexpr size_type replace_impl(size_type idx, U &&value)
 		{
+			base_t::assert_writable();
+
 			auto &ref = component_ref(idx);
-			if constexpr (std::is_assignable_v<T &, U &&>)
+			if constexpr (is_keyed)
+			{
+				/* Construct the new value first, so that a duplicate key leaves the component unchanged & indexed. */
+				T tmp{std::forward<U>(value)};
+				if (!index_available(tmp, idx)) [[unlikely]]
+					duplicate_key();
+
+				index_erase(idx);
+				reassign(ref, std::move(tmp));
+				index_insert(idx);
+			}
+			else if constexpr (std::is_assignable_v<T &, U &&>)
 				ref = std::forward<U>(value);
 			else if constexpr (std::is_move_assignable_v<T>)
 				ref = T{std::forward<U>(value)};
@@ -1420,6 +2125,7 @@ namespace sek
 				std::destroy_at(std::addressof(ref));
 				std::construct_at(std::addressof(ref), std::forward<U>(value));
 			}
+
 			dispatch_modify(idx);
 			return idx;
 		}
@@ -1427,6 +2133,8 @@ namespace sek
 		template<typename... Args>
 		constexpr size_type emplace_back_impl(entity_t entity, Args &&...args)
 		{
+			base_t::assert_writable();
+
 			const auto pos = base_t::push_back_(entity);
 			try
 			{
@@ -1439,14 +2147,24 @@ namespace sek
 				base_t::erase_(pos);
 				throw;
 			}
+			if (!index_insert(pos)) [[unlikely]]
+			{
+				/* Key is already used by another component, thus undo the creation. */
+				m_pool.erase(pos);
+				base_t::erase_(pos);
+				duplicate_key();
+			}
 
-			/* Component created successfully, dispatch event & return. */
+			/* Component created successfully, dispatch event & return. Handlers may move the component,
+			 * thus re-acquire entity index. */
 			base_t::dispatch_create(pos);
-			return pos;
+			return base_t::offset(entity);
 		}
 		template<typename... Args>
 		constexpr size_type emplace_impl(entity_t entity, Args &&...args)
 		{
+			base_t::assert_writable();
+
 			const auto pos = base_t::insert_(entity);
 			try
 			{
@@ -1454,15 +2172,23 @@ namespace sek
 			}
 			catch (...)
 			{
-				/* If exceptions were encountered during emplacement, erase the entity.
-				 * Always swap & pop, since the component does not exist. */
-				base_t::erase_(pos);
+				/* If exceptions were encountered during emplacement, erase the entity. The position may be a re-used
+				 * tombstone within the dense array, thus return it to the free list instead of swapping & popping. */
+				base_t::fixed_erase_(pos);
 				throw;
 			}
+			if (!index_insert(pos)) [[unlikely]]
+			{
+				/* Key is already used by another component, thus undo the creation. */
+				m_pool.erase(pos);
+				base_t::fixed_erase_(pos);
+				duplicate_key();
+			}
 
-			/* Component created successfully, dispatch event & return. */
+			/* Component created successfully, dispatch event & return. Handlers may move the component,
+			 * thus re-acquire entity index. */
 			base_t::dispatch_create(pos);
-			return pos;
+			return base_t::offset(entity);
 		}
 
 		/* basic_entity_set overrides */
@@ -1481,14 +2207,21 @@ namespace sek
 
 		constexpr size_type fixed_erase_(size_type idx) final
 		{
-			/* Fixed components will not be moved by the handler (or at least should not be),
-			 * thus no need to re-acquire entity index. */
+			base_t::assert_writable();
+
+			/* Locked components will not be moved by the handler, however this function is also used by `clear`
+			 * for unlocked components, which may be moved. Because of this, re-acquire entity index. */
+			const auto e = base_t::at(idx);
 			dispatch_remove(idx);
+
+			idx = base_t::offset(e);
+			index_erase(idx);
 			m_pool.erase(idx);
 			return base_t::erase_(idx);
 		}
 		constexpr size_type erase_(size_type idx) final
 		{
+			base_t::assert_writable();
 			if (is_locked(idx))
 				return fixed_erase_(idx);
 			else
@@ -1500,6 +2233,7 @@ namespace sek
 
 				const auto last = size() - 1;
 				idx = base_t::offset(e);
+				index_erase(idx);
 
 				/* Move the last component to the erased one, then erase the last to account for swap & pop. */
 				m_pool.move_value(idx, last);
@@ -1509,16 +2243,36 @@ namespace sek
 			}
 		}
 
-		constexpr void move_(size_type to, size_type from) final { m_pool.move_value(to, from); }
-		constexpr void swap_(size_type lhs, size_type rhs) final { m_pool.swap_value(lhs, rhs); }
+		constexpr void move_(size_type to, size_type from) final
+		{
+			base_t::assert_writable();
+			m_pool.move_value(to, from);
+		}
+		constexpr void swap_(size_type lhs, size_type rhs) final
+		{
+			base_t::assert_writable();
+			m_pool.swap_value(lhs, rhs);
+		}
 
 		/* generic_component_set overrides */
-		bool lock(base_iter which) noexcept final
+		void remap_(const entity_remap &table) final
+		{
+			base_t::assert_writable();
+			base_t::remap(table);
+			remap_events(table);
+
+			/* Key indices refer to entities, thus need to be rebuilt. */
+			m_index.clear();
+			for (size_type i = 0; i < size(); ++i)
+				if (!at(i).is_tombstone()) index_insert(i);
+		}
+
+		bool lock(base_iter which) final
 		{
 			const auto idx = which.offset();
 			return set_locked(idx, at(idx), true);
 		}
-		bool unlock(base_iter which) noexcept final
+		bool unlock(base_iter which) final
 		{
 			const auto idx = which.offset();
 			return set_locked(idx, at(idx), false);
@@ -1579,6 +2333,7 @@ namespace sek
 		using base_t::swap;
 
 		pool_t m_pool;
+		[[no_unique_address]] detail::component_index<T> m_index;
 	};
 
 	/** @brief Structure used to indirectly reference a component through an entity from a component set. */
@@ -1672,10 +2427,10 @@ namespace sek
 
 		/** Locks the pointed-to component.
 		 * @return `true` if the component was previously unlocked, `false` otherwise. */
-		constexpr bool lock() noexcept { return m_set->lock(m_entity); }
+		constexpr bool lock() { return m_set->lock(m_entity); }
 		/** Unlocks the pointed-to component.
 		 * @return `true` if the component was previously locked, `false` otherwise. */
-		constexpr bool unlock() noexcept { return m_set->unlock(m_entity); }
+		constexpr bool unlock() { return m_set->unlock(m_entity); }
 
 		/** Enables the pointed-to component.
 		 * @return `true` if the component was previously disabled, `false` otherwise. */
@@ -0,0 +1,195 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "query_plan.hpp"
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Type-erased query over component sets selected at runtime.
+	 *
+	 * Dynamic queries resolve their component sets once when created, and iterate the main set while testing entities
+	 * against the rest of the query. The main set and the order of tests are selected the same way `component_view`
+	 * does (see `detail::query_plan`). Components are accessed via `any_ref` without any per-entity type lookups,
+	 * components of the main set are read a run at a time (see `generic_component_set::get_any_span`).
+	 *
+	 * @note If any of the included component types does not have storage, the query is empty.
+	 * @note Bitset tag types (see `tag_set`) do not have generic component sets, and are treated as types without storage.
+	 * @note Dynamic queries do not track creation of new component sets. */
+	class dynamic_query
+	{
+	public:
+		typedef std::size_t size_type;
+
+	public:
+		/** Initializes an empty query. */
+		constexpr dynamic_query() noexcept = default;
+
+		/** Initializes a dynamic query for the specified world.
+		 * @param world World to query.
+		 * @param included Types of included components.
+		 * @param excluded Types of excluded components.
+		 * @param optional Types of optional components.
+		 * @param enabled Included types, entities of which are only accepted while the component is enabled. */
+		dynamic_query(entity_world &world,
+					  std::span<const type_info> included,
+					  std::span<const type_info> excluded = {},
+					  std::span<const type_info> optional = {},
+					  std::span<const type_info> enabled = {})
+		{
+			SEK_ASSERT(!included.empty(), "Dynamic query must include at least 1 component type");
+
+			for (auto type : included)
+				if (const auto set = world.storage(type); set != nullptr) [[likely]]
+					m_included.push_back(set);
+				else
+					return;
+			for (auto type : excluded)
+				if (const auto set = world.storage(type); set != nullptr) m_excluded.push_back(set);
+			for (auto type : optional) m_optional.push_back(world.storage(type));
+			for (auto type : enabled)
+			{
+				SEK_ASSERT(std::ranges::find(included, type) != included.end(), "Enabled-only component types must be included");
+				m_enabled.push_back(world.storage(type));
+			}
+
+			/* Included sets keep the order of their types, thus position of the main set is stored separately. */
+			m_tests.reserve(m_included.size() + m_excluded.size());
+			for (auto set : m_included) m_tests.push_back({set, false});
+			for (auto set : m_excluded) m_tests.push_back({set, true});
+
+			constexpr auto cmp = [](auto *a, auto *b) { return a->size() < b->size(); };
+			constexpr auto is_large = [](auto *set) { return set->size() >= detail::query_plan::plan_threshold; };
+			if (m_tests.size() > 1 && std::ranges::any_of(m_included, is_large))
+				plan();
+			else
+				m_set = *std::min_element(m_included.begin(), m_included.end(), cmp);
+			m_main = static_cast<size_type>(std::ranges::find(m_included, m_set) - m_included.begin());
+		}
+
+		/** Returns the size of the main set (approximate size of the query). */
+		[[nodiscard]] constexpr size_type size_hint() const noexcept { return m_set != nullptr ? m_set->size() : 0; }
+		/** Returns the amount of components (included + optional) returned for every entity. */
+		[[nodiscard]] constexpr size_type component_count() const noexcept
+		{
+			return m_included.size() + m_optional.size();
+		}
+
+		/** Checks if the query contains the specified entity. */
+		[[nodiscard]] constexpr bool contains(entity_t e) const noexcept
+		{
+			return m_set != nullptr && m_set->contains(e) && accept(e);
+		}
+
+		/** Writes references to included & optional components of the entity into the buffer (in the order of types
+		 * passed to the constructor). References to missing optional components are empty.
+		 * @param e Entity to get components for.
+		 * @param out Buffer receiving component references. Must be at least `component_count()` in size.
+		 * @warning Using an entity not belonging to the query results in undefined behavior. */
+		void get(entity_t e, std::span<any_ref> out) const
+		{
+			SEK_ASSERT(m_set != nullptr);
+			SEK_ASSERT(out.size() >= component_count());
+			fill(e, m_set->get_any(m_set->offset(e)), out);
+		}
+
+		/** Invokes the functor for every entity of the query. */
+		template<std::invocable<entity_t> F>
+		void for_each(F &&f) const
+		{
+			iterate([&](entity_t e, const any_span &, size_type) { std::invoke(f, e); });
+		}
+		/** Invokes the functor for every entity of the query and a span of references to it's included & optional
+		 * components (in the order of types passed to the constructor).
+		 * References to missing optional components are empty. */
+		template<std::invocable<entity_t, std::span<any_ref>> F>
+		void for_each(F &&f) const
+		{
+			std::vector<any_ref> buffer(component_count());
+			iterate(
+				[&](entity_t e, const any_span &run, size_type j)
+				{
+					fill(e, any_ref{run.type, run.get(j)}, buffer);
+					std::invoke(f, e, std::span<any_ref>{buffer});
+				});
+		}
+
+	private:
+		struct set_test
+		{
+			generic_component_set *set;
+			bool exclude;
+		};
+
+		void plan()
+		{
+			const std::vector<const generic_component_set *> sets(m_included.begin(), m_included.end());
+			m_set = const_cast<generic_component_set *>(detail::query_plan::select_main(sets, m_tests.size()));
+
+			std::vector<std::pair<size_type, size_type>> stats(m_tests.size());
+			for (size_type i = 0; i < stats.size(); ++i) stats[i] = {0, i};
+			detail::query_plan::order_tests<size_type>(m_set, stats, [this](size_type i, entity_t e) { return test(m_tests[i], e); });
+
+			std::vector<set_test> tests;
+			tests.reserve(m_tests.size());
+			for (auto &stat : stats) tests.push_back(m_tests[stat.second]);
+			m_tests = std::move(tests);
+		}
+
+		[[nodiscard]] constexpr bool test(const set_test &t, entity_t e) const noexcept
+		{
+			/* Entities are either taken from the main set or tested against it by the caller. */
+			return t.set == m_set || t.set->contains(e) != t.exclude;
+		}
+		[[nodiscard]] constexpr bool accept(entity_t e) const noexcept
+		{
+			for (auto &t : m_tests)
+				if (!test(t, e)) return false;
+			for (auto set : m_enabled)
+				if (!set->is_enabled(e)) return false;
+			return true;
+		}
+
+		/* Invokes `f(e, run, j)` for every accepted entity, where `run` is the run of main set components containing
+		 * the component of the entity at index `j`. */
+		template<typename F>
+		void iterate(F &&f) const
+		{
+			if (m_set == nullptr) [[unlikely]]
+				return;
+
+			const auto *data = m_set->data();
+			for (size_type i = 0, n = m_set->size(); i != n;)
+			{
+				const auto run = m_set->get_any_span(i);
+				for (size_type j = 0; j != run.size; ++j)
+					if (const auto e = data[i + j]; !e.is_tombstone() && accept(e)) f(e, run, j);
+				i += run.size;
+			}
+		}
+
+		void fill(entity_t e, any_ref main, std::span<any_ref> out) const
+		{
+			/* Components of the main set are read by the caller, the rest are accessed by entity. */
+			auto pos = out.begin();
+			for (size_type i = 0; i < m_included.size(); ++i)
+				*pos++ = i == m_main ? main : m_included[i]->get_any(e);
+			for (auto set : m_optional) *pos++ = set != nullptr && set->contains(e) ? set->get_any(e) : any_ref{};
+		}
+
+		generic_component_set *m_set = nullptr;
+		size_type m_main = 0; /* Position of the main set within included sets. */
+		std::vector<generic_component_set *> m_included;
+		std::vector<generic_component_set *> m_excluded;
+		std::vector<generic_component_set *> m_optional;
+		std::vector<generic_component_set *> m_enabled;
+		std::vector<set_test> m_tests; /* Include & exclude tests, in order of evaluation. */
+	};
+}	 // namespace sek
@@ -6,6 +6,11 @@
 
 #include <algorithm>
 #include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include "../../../assert.hpp"
@@ -19,19 +24,41 @@ namespace sek
 	 * Entities have an index, used to uniquely identify an entity, and a version,
 	 * used to disambiguate entities that have been previously "deleted" from their world.
 	 * Entities that do not represent a valid group of components are "tombstone" entities.
-	 * Tombstone entities always compare equal to each other. */
+	 * Tombstone entities always compare equal to each other.
+	 *
+	 * By default, entities are `std::size_t`-wide with a 24-bit version (16-bit for 32-bit platforms). Defining
+	 * `SEK_WORLD_ENTITY_32` makes entities 32-bit (halving memory of entity sets), and `SEK_WORLD_ENTITY_VERSION_BITS`
+	 * selects the amount of version bits (12 by default for 32-bit entities, for a 20/12 index/version split).
+	 * All remaining bits are used for the index, which also limits the size of individual entity sets. */
 	class entity_t
 	{
 	public:
+#ifdef SEK_WORLD_ENTITY_32
+		typedef std::uint32_t value_type;
+#else
 		typedef std::size_t value_type;
+#endif
+
+	private:
+#if defined(SEK_WORLD_ENTITY_VERSION_BITS)
+		constexpr static value_type version_bits = SEK_WORLD_ENTITY_VERSION_BITS;
+#elif defined(SEK_WORLD_ENTITY_32)
+		constexpr static value_type version_bits = 12;
+#else
+		constexpr static value_type version_bits = sizeof(value_type) >= sizeof(std::uint64_t) ? 24 : 16;
+#endif
+		constexpr static value_type index_bits = std::numeric_limits<value_type>::digits - version_bits;
 
+		static_assert(version_bits >= 2 && index_bits >= 2, "Invalid entity version bit count");
+
+	public:
 		/** @brief Structure used to represent an entity version. */
 		class version_type
 		{
 			friend class entity_t;
 
-			constexpr static value_type mask = sizeof(value_type) >= sizeof(std::uint64_t) ? 0xff'ffff : 0xffff;
-			constexpr static value_type offset = sizeof(value_type) >= sizeof(std::uint64_t) ? 40 : 16;
+			constexpr static value_type mask = (value_type{1} << version_bits) - 1;
+			constexpr static value_type offset = index_bits;
 
 		public:
 			/** Returns tombstone value of entity version. */
@@ -42,9 +69,15 @@ namespace sek
 		public:
 			constexpr version_type() noexcept = default;
 
-			/** Initializes an entity version from an underlying value type.
-			 * @note Value must be 24-bit max. */
-			constexpr explicit version_type(value_type value) noexcept : m_value(value << offset) {}
+			/** Initializes an entity version from an integer value.
+			 * @note Value must not exceed the version bit count. Excess bits are discarded. */
+			template<std::integral I>
+			constexpr explicit version_type(I value) noexcept
+				: m_value((static_cast<value_type>(value) & mask) << offset)
+			{
+				SEK_ASSERT(std::cmp_greater_equal(value, 0) && std::cmp_less_equal(value, mask),
+						   "Entity version is out of range");
+			}
 
 			/** Checks if the entity version is a tombstone. */
 			[[nodiscard]] constexpr bool is_tombstone() const noexcept { return *this == tombstone(); }
@@ -65,7 +98,7 @@ namespace sek
 		{
 			friend class entity_t;
 
-			constexpr static value_type mask = sizeof(value_type) == sizeof(std::uint64_t) ? 0xff'ffff'ffff : 0xffff;
+			constexpr static value_type mask = (value_type{1} << index_bits) - 1;
 
 		public:
 			/** Returns tombstone value of entity index. */
@@ -76,9 +109,14 @@ namespace sek
 		public:
 			constexpr index_type() noexcept = default;
 
-			/** Initializes an entity index from an underlying value type.
-			 * @note Value must be 40-bit max. */
-			constexpr explicit index_type(value_type value) noexcept : m_value(value) {}
+			/** Initializes an entity index from an integer value.
+			 * @note Value must not exceed the index bit count. Excess bits are discarded. */
+			template<std::integral I>
+			constexpr explicit index_type(I value) noexcept : m_value(static_cast<value_type>(value) & mask)
+			{
+				SEK_ASSERT(std::cmp_greater_equal(value, 0) && std::cmp_less_equal(value, mask),
+						   "Entity index is out of range");
+			}
 
 			/** Checks if the entity index is a tombstone. */
 			[[nodiscard]] constexpr bool is_tombstone() const noexcept { return *this == tombstone(); }
@@ -145,6 +183,49 @@ namespace sek
 	}
 
 	[[nodiscard]] constexpr hash_t hash(entity_t e) noexcept { return e.value(); }
+
+	/** @brief Table of entities renumbered by `entity_world::defragment`.
+	 *
+	 * The table stores both the old and the new entity of every old index, so that stale handles (entities with an
+	 * outdated version of an index) are never mapped to the entity that occupied the index at the time of the remap. */
+	class entity_remap
+	{
+	public:
+		typedef std::size_t size_type;
+
+	public:
+		constexpr entity_remap() noexcept = default;
+		/** Initializes the table from old & new entities, both indexed by the old entity index.
+		 * Old entities of indices that were not alive must be tombstones. */
+		constexpr entity_remap(std::vector<entity_t> from, std::vector<entity_t> to) noexcept
+			: m_from(std::move(from)), m_to(std::move(to))
+		{
+			SEK_ASSERT(m_from.size() == m_to.size(), "Remap tables must be of the same size");
+		}
+
+		/** Returns the amount of old indices of the table. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_from.size(); }
+		/** Returns the old entities, indexed by the old entity index. */
+		[[nodiscard]] constexpr const std::vector<entity_t> &old_entities() const noexcept { return m_from; }
+		/** Returns the new entities, indexed by the old entity index. */
+		[[nodiscard]] constexpr const std::vector<entity_t> &new_entities() const noexcept { return m_to; }
+
+		/** Checks if the entity (including it's version) was alive at the time of the remap. */
+		[[nodiscard]] constexpr bool contains(entity_t e) const noexcept
+		{
+			const auto idx = e.index().value();
+			return !e.is_tombstone() && idx < m_from.size() && m_from[idx].value() == e.value();
+		}
+		/** Returns the new entity of `e`, or a tombstone if `e` was not alive at the time of the remap. */
+		[[nodiscard]] constexpr entity_t operator[](entity_t e) const noexcept
+		{
+			return contains(e) ? m_to[e.index().value()] : entity_t::tombstone();
+		}
+
+	private:
+		std::vector<entity_t> m_from;
+		std::vector<entity_t> m_to;
+	};
 }	 // namespace sek
 
 template<>
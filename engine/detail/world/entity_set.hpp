@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <span>
+
 #include "entity.hpp"
 #include "traits.hpp"
 
@@ -190,6 +192,7 @@ namespace sek
 				m_sparse = other.m_sparse;
 				m_dense = other.m_dense;
 				m_next = other.m_next;
+				++m_layout;
 				copy_sparse(other);
 			}
 			return *this;
@@ -220,6 +223,7 @@ namespace sek
 			m_sparse = std::move(other.m_sparse);
 			m_dense = std::move(other.m_dense);
 			m_next = std::move(other.m_next);
+			++m_layout;
 
 			if (!sek::detail::alloc_eq(alloc(), other.alloc())) [[unlikely]]
 				move_sparse(other);
@@ -317,6 +321,10 @@ namespace sek
 		/** Checks if the size of the set is `0`.
 		 * @note Result may be incorrect if any tombstones are present. */
 		[[nodiscard]] constexpr bool empty() const noexcept { return m_dense.empty(); }
+		/** Returns the layout version of the set, which is incremented whenever entities are moved between offsets or
+		 * dropped in bulk (ex. by sorting, packing, swapping or clearing the set). Insertion & removal of individual
+		 * entities (including the swap & pop of the last entity on removal) does not change the layout version. */
+		[[nodiscard]] constexpr size_type layout_version() const noexcept { return m_layout; }
 
 		/** Checks if the set contains the specified entity. */
 		[[nodiscard]] constexpr bool contains(entity_t entity) const noexcept
@@ -374,6 +382,7 @@ namespace sek
 			}
 			m_dense.clear();
 			m_next = entity_t::tombstone();
+			++m_layout;
 		}
 
 		/** Updates version of an entity contained within the set.
@@ -389,9 +398,34 @@ namespace sek
 			m_dense[slot.index().value()] = entity_t{gen, idx};
 		}
 
+		/** Replaces entities of the set using a remap table. Offsets of remaining entities within the set are preserved.
+		 * @param table Table of old & new entities. Indices of new entities must be unique.
+		 * @note Entities that were not alive at the time of the remap (including stale versions of re-used indices)
+		 * are removed from the set without invoking erase hooks. */
+		constexpr void remap(const entity_remap &table)
+		{
+			++m_layout;
+
+			/* Release all sparse slots first, since new indices may overlap the old ones. */
+			for (auto e : m_dense)
+				if (!e.is_tombstone()) sparse_ref(e.index().value()) = entity_t::tombstone();
+			for (size_type i = 0; i < m_dense.size(); ++i)
+				if (auto &e = m_dense[i]; !e.is_tombstone())
+				{
+					if (const auto to = table[e]; !to.is_tombstone()) [[likely]]
+					{
+						e = to;
+						insert_sparse(e.index().value()) = entity_t{e.version(), entity_t::index_type{i}};
+					}
+					else
+						e = std::exchange(m_next, entity_t{entity_t::version_type::tombstone(), entity_t::index_type{i}});
+				}
+		}
+
 		/** Swaps entities of the entity set. */
 		constexpr void swap(size_type a, size_type b)
 		{
+			++m_layout;
 			swap_(a, b);
 			auto &lhs = m_dense[a];
 			auto &rhs = m_dense[b];
@@ -417,6 +451,7 @@ namespace sek
 				to = ptr->index().value();
 				if (to < from)
 				{
+					++m_layout;
 					move_(to, --from);
 
 					auto &e_from = m_dense[from];
@@ -445,6 +480,7 @@ namespace sek
 			SEK_ASSERT(m_next.is_tombstone(), "Dense array must be packed for sorting");
 
 			/* Sort dense entity array, then fix sparse entities. */
+			++m_layout;
 			invoke_sort(std::forward<Sort>(sort), n, std::forward<Args>(args)...);
 			for (auto item = begin(), last = iterator{this, n}; item != last; ++item)
 			{
@@ -566,6 +602,8 @@ namespace sek
 			swap(m_sparse, other.m_sparse);
 			swap(m_dense, other.m_dense);
 			swap(m_next, other.m_next);
+			++m_layout;
+			++other.m_layout;
 		}
 		friend constexpr void swap(basic_entity_set &a, basic_entity_set &b) noexcept { a.swap(b); }
 
@@ -710,11 +748,24 @@ namespace sek
 		constexpr virtual void swap_(size_type, size_type) {}
 		constexpr virtual void move_(size_type, size_type) {}
 
+		/* Removes all entities without invoking erase hooks. */
+		constexpr void clear_silent() noexcept
+		{
+			for (auto e : m_dense)
+				if (!e.is_tombstone()) [[likely]]
+					sparse_ref(e.index().value()) = entity_t::tombstone();
+			m_dense.clear();
+			m_next = entity_t::tombstone();
+			++m_layout;
+		}
+
 		sparse_data m_sparse;
 		dense_data m_dense;
 
 		/* Next dense entity available for reuse. */
 		entity_t m_next = entity_t::tombstone();
+		/* Incremented when entities are moved or dropped in bulk. */
+		size_type m_layout = 0;
 	};
 
 	using entity_set = basic_entity_set<>;
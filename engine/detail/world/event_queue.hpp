@@ -0,0 +1,151 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "entity.hpp"
+#include "thread_index.hpp"
+
+namespace sek
+{
+	/** @brief Tag type used to subscribe deferred listeners to component events.
+	 *
+	 * Deferred listeners are not invoked when the event is raised. Instead, the event is recorded into a queue local
+	 * to the calling thread and is delivered when `entity_world::flush_events` is called. */
+	struct deferred_t
+	{
+	};
+	/** Instance of `deferred_t`. */
+	constexpr inline deferred_t deferred = {};
+
+	namespace detail
+	{
+		enum class event_kind : std::uint8_t
+		{
+			create,
+			modify,
+			remove,
+			lock,
+			enable,
+		};
+		struct deferred_event
+		{
+			entity_t entity;
+			event_kind kind;
+			bool value;
+		};
+
+		/* Queue of deferred component events. Events are recorded into per-thread buffers without synchronization
+		 * (buffers are only registered under a lock once per thread, see `thread_slots`), and are merged when the
+		 * queue is flushed. State of the queue is only allocated by the first recorded event, thus queues of sets
+		 * without deferred listeners do not allocate. */
+		class event_queue
+		{
+			struct buffer
+			{
+				std::vector<deferred_event> events;
+			};
+			using state = thread_slots<buffer>;
+
+		public:
+			event_queue(const event_queue &) = delete;
+			event_queue &operator=(const event_queue &) = delete;
+
+			event_queue() noexcept = default;
+			event_queue(event_queue &&other) noexcept : m_state(other.m_state.exchange(nullptr, std::memory_order_relaxed))
+			{
+			}
+			event_queue &operator=(event_queue &&other) noexcept
+			{
+				auto tmp = event_queue{std::move(other)};
+				swap(tmp);
+				return *this;
+			}
+			~event_queue() { delete m_state.load(std::memory_order_relaxed); }
+
+			/* Records an event into the buffer of the calling thread.
+			 * Throws `std::length_error` if the calling thread can not be assigned a buffer. */
+			void push(deferred_event event) { get_state().local().events.push_back(event); }
+
+			/* Delivers all recorded events to the functor. Events are ordered by entity, while events of the same
+			 * entity keep the order in which they were recorded, thus the delivery order does not depend on thread
+			 * scheduling as long as every entity is only modified by one thread at a time.
+			 * Events recorded by the functor are delivered on the next flush. */
+			template<typename F>
+			void flush(F &&f)
+			{
+				const auto s = m_state.load(std::memory_order_acquire);
+				if (s == nullptr) return;
+
+				std::vector<deferred_event> events;
+				s->for_each(
+					[&](buffer &buff)
+					{
+						events.insert(events.end(), buff.events.begin(), buff.events.end());
+						buff.events.clear();
+					});
+
+				constexpr auto cmp = [](const deferred_event &a, const deferred_event &b) noexcept
+				{
+					return a.entity.index().value() < b.entity.index().value();
+				};
+				std::stable_sort(events.begin(), events.end(), cmp);
+				for (auto &event : events) f(event);
+			}
+
+			/* Drops all recorded events. Buffers are retained. */
+			void clear() noexcept
+			{
+				if (const auto s = m_state.load(std::memory_order_acquire); s != nullptr)
+					s->for_each([](buffer &buff) { buff.events.clear(); });
+			}
+
+			/* Replaces entities of recorded events using a remap table. Events of entities that were not alive at the
+			 * time of the remap (including stale versions of re-used indices) are dropped, since their indices may be
+			 * re-used by the remapped entities. */
+			void remap(const entity_remap &table)
+			{
+				const auto s = m_state.load(std::memory_order_acquire);
+				if (s == nullptr) return;
+
+				s->for_each(
+					[&](buffer &buff)
+					{
+						auto &events = buff.events;
+						std::erase_if(events, [&](const deferred_event &event) { return !table.contains(event.entity); });
+						for (auto &event : events) event.entity = table[event.entity];
+					});
+			}
+
+			void swap(event_queue &other) noexcept
+			{
+				const auto s = m_state.load(std::memory_order_relaxed);
+				m_state.store(other.m_state.exchange(s, std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			friend void swap(event_queue &a, event_queue &b) noexcept { a.swap(b); }
+
+		private:
+			[[nodiscard]] state &get_state()
+			{
+				if (const auto s = m_state.load(std::memory_order_acquire); s != nullptr) [[likely]]
+					return *s;
+
+				/* Multiple threads may record the first event at the same time, only one of them publishes it's state. */
+				auto s = std::make_unique<state>();
+				if (state *expected = nullptr; !m_state.compare_exchange_strong(expected, s.get(), std::memory_order_acq_rel))
+					return *expected;
+				return *s.release();
+			}
+
+			std::atomic<state *> m_state = nullptr;
+		};
+	}	 // namespace detail
+}	 // namespace sek
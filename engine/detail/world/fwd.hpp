@@ -28,14 +28,18 @@ namespace sek
 	struct optional_t;
 	template<typename...>
 	struct excluded_t;
+	template<typename...>
+	struct enabled_t;
 
 	class entity_world;
 
-	template<typename, typename, typename, typename, typename>
+	template<typename, typename, typename, typename, typename, typename>
 	class entity_query;
-	template<typename, typename, typename>
-	class component_view;
 	template<typename, typename, typename, typename>
+	class component_view;
+	template<typename, typename, typename, typename, typename>
 	class component_collection;
+	template<typename, typename, typename>
+	class entity_observer;
 
 }	 // namespace sek
\ No newline at end of file
@@ -0,0 +1,259 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <span>
+
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Component used to link entities into an `entity_hierarchy`.
+	 * @note Links & depth are managed by the hierarchy, only the parent is used when a node is created. */
+	struct hierarchy_node
+	{
+		/** Parent of the node or a tombstone for root nodes. */
+		entity_t parent = entity_t::tombstone();
+		/** First child of the node. */
+		entity_t first_child = entity_t::tombstone();
+		/** Next sibling of the node. */
+		entity_t next_sibling = entity_t::tombstone();
+		/** Distance of the node from the root. */
+		std::size_t depth = 0;
+	};
+
+	/** @brief Structure used to keep `hierarchy_node` components of a world in breadth-first order.
+	 *
+	 * Nodes of the hierarchy are grouped by depth (level) within the dense array of the `hierarchy_node`
+	 * component set, such that every parent precedes all of it's children. This allows propagation of hierarchical
+	 * data (ex. transforms) to be preformed as a linear sweep over levels, where nodes of the same level are
+	 * independent of each other and can be processed in parallel.
+	 *
+	 * The order is updated incrementally - moving a node between levels takes one swap per level crossed.
+	 *
+	 * @note Only one hierarchy may be bound to a world at a time, and it must be created before any `hierarchy_node`
+	 * components are added to the world. The hierarchy must not outlive it's world.
+	 * @note Hierarchy nodes must not be locked, sorted or owned by collections. Locking a hierarchy node triggers
+	 * an assertion. */
+	class entity_hierarchy
+	{
+		static_assert(!detail::transient_component<hierarchy_node>, "Hierarchy nodes can not be transient");
+
+	public:
+		typedef std::size_t size_type;
+
+	public:
+		entity_hierarchy(const entity_hierarchy &) = delete;
+		entity_hierarchy &operator=(const entity_hierarchy &) = delete;
+		entity_hierarchy(entity_hierarchy &&) = delete;
+		entity_hierarchy &operator=(entity_hierarchy &&) = delete;
+
+		/** Binds the hierarchy to the specified world. */
+		explicit entity_hierarchy(entity_world &world) : m_set(&world.template reserve<hierarchy_node>())
+		{
+			SEK_ASSERT(m_set->empty(), "Hierarchy must be created before any hierarchy nodes");
+
+			m_set->on_create() += delegate{delegate_func_t<&entity_hierarchy::handle_create>{}, this};
+			m_set->on_remove() += delegate{delegate_func_t<&entity_hierarchy::handle_remove>{}, this};
+			m_set->on_lock() += delegate{delegate_func_t<&entity_hierarchy::handle_lock>{}, this};
+			world.on_remap() += delegate{delegate_func_t<&entity_hierarchy::handle_remap>{}, this};
+		}
+		~entity_hierarchy()
+		{
+			m_set->on_create() -= delegate{delegate_func_t<&entity_hierarchy::handle_create>{}, this};
+			m_set->on_remove() -= delegate{delegate_func_t<&entity_hierarchy::handle_remove>{}, this};
+			m_set->on_lock() -= delegate{delegate_func_t<&entity_hierarchy::handle_lock>{}, this};
+			m_set->world().on_remap() -= delegate{delegate_func_t<&entity_hierarchy::handle_remap>{}, this};
+		}
+
+		/** Returns the amount of nodes in the hierarchy. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_set->size(); }
+		/** Returns the amount of levels in the hierarchy (depth of the deepest node + 1). */
+		[[nodiscard]] constexpr size_type levels() const noexcept { return m_ends.size(); }
+
+		/** Returns dense offsets `[first, last)` of nodes at the specified level within the `hierarchy_node` set. */
+		[[nodiscard]] constexpr std::pair<size_type, size_type> level_bounds(size_type l) const noexcept
+		{
+			return {level_begin(l), m_ends[l]};
+		}
+		/** Returns span of entities at the specified level. */
+		[[nodiscard]] constexpr std::span<const entity_t> level(size_type l) const noexcept
+		{
+			const auto [first, last] = level_bounds(l);
+			return {m_set->data() + first, last - first};
+		}
+
+		/** Returns reference to the underlying `hierarchy_node` component set. */
+		[[nodiscard]] constexpr const component_set<hierarchy_node> &storage() const noexcept { return *m_set; }
+
+		/** Returns the parent of the specified entity or a tombstone if the entity is a root node. */
+		[[nodiscard]] constexpr entity_t parent(entity_t e) const noexcept { return m_set->get(e).parent; }
+		/** Returns depth of the specified entity. */
+		[[nodiscard]] constexpr size_type depth(entity_t e) const noexcept { return m_set->get(e).depth; }
+
+		/** Invokes the functor for every child of the specified entity. */
+		template<std::invocable<entity_t> F>
+		constexpr void for_each_child(entity_t e, F &&f) const
+		{
+			for (auto child = m_set->get(e).first_child; !child.is_tombstone(); child = m_set->get(child).next_sibling)
+				std::invoke(f, child);
+		}
+
+		/** Adds the entity to the hierarchy as a child of `parent` (or as a root node if `parent` is a tombstone). */
+		constexpr void insert(entity_t e, entity_t parent = entity_t::tombstone())
+		{
+			m_set->emplace_back(e, hierarchy_node{.parent = parent});
+		}
+		/** Removes the entity from the hierarchy. Children of the entity become root nodes. */
+		constexpr void erase(entity_t e) { m_set->erase(e); }
+
+		/** Changes the parent of an entity. Depth of the entity's sub-tree is updated accordingly.
+		 * @param e Entity to re-parent.
+		 * @param parent New parent of the entity or a tombstone to make the entity a root node. */
+		constexpr void set_parent(entity_t e, entity_t parent)
+		{
+			SEK_ASSERT(!is_ancestor(e, parent), "Hierarchy cycles are not allowed");
+
+			unlink(e);
+			link(e, parent);
+			relevel(e, parent.is_tombstone() ? 0 : node(parent).depth + 1);
+			trim_levels();
+		}
+
+	private:
+		[[nodiscard]] constexpr hierarchy_node &node(entity_t e) noexcept { return m_set->get(e); }
+		[[nodiscard]] constexpr size_type level_begin(size_type l) const noexcept { return l == 0 ? 0 : m_ends[l - 1]; }
+		[[nodiscard]] constexpr size_type nodes_end() const noexcept { return m_ends.empty() ? 0 : m_ends.back(); }
+
+		[[nodiscard]] constexpr bool is_ancestor(entity_t a, entity_t e) const noexcept
+		{
+			for (; !e.is_tombstone(); e = m_set->get(e).parent)
+				if (e == a) return true;
+			return false;
+		}
+
+		constexpr void link(entity_t e, entity_t parent)
+		{
+			node(e).parent = parent;
+			if (!parent.is_tombstone()) node(e).next_sibling = std::exchange(node(parent).first_child, e);
+		}
+		constexpr void unlink(entity_t e)
+		{
+			const auto parent = std::exchange(node(e).parent, entity_t::tombstone());
+			const auto next = std::exchange(node(e).next_sibling, entity_t::tombstone());
+			if (parent.is_tombstone()) return;
+
+			if (auto prev = node(parent).first_child; prev == e)
+				node(parent).first_child = next;
+			else
+			{
+				while (node(prev).next_sibling != e) prev = node(prev).next_sibling;
+				node(prev).next_sibling = next;
+			}
+		}
+
+		/* Moves a node from level `from` to level `to`, one level at a time. Every step swaps the node with the
+		 * boundary node of the level it is leaving, which stays in the same level. */
+		constexpr void move_level(entity_t e, size_type from, size_type to)
+		{
+			while (m_ends.size() <= to) m_ends.push_back(m_ends.back());
+
+			for (; from < to; ++from)
+			{
+				const auto last = --m_ends[from];
+				if (const auto pos = m_set->offset(e); pos != last) m_set->swap(pos, last);
+			}
+			for (; from > to; --from)
+			{
+				const auto first = m_ends[from - 1]++;
+				if (const auto pos = m_set->offset(e); pos != first) m_set->swap(pos, first);
+			}
+			node(e).depth = to;
+		}
+		/* Moves the sub-tree of a node to the specified depth. Nodes are visited using an explicit stack instead
+		 * of recursion, thus deep hierarchies do not overflow the call stack. */
+		constexpr void relevel(entity_t e, size_type depth)
+		{
+			m_stack.push_back(e);
+			while (!m_stack.empty())
+			{
+				const auto next = m_stack.back();
+				m_stack.pop_back();
+
+				/* Depth of a child is derived from it's parent, which is always moved first. */
+				const auto parent = node(next).parent;
+				const auto target = next == e ? depth : node(parent).depth + 1;
+				if (const auto old = node(next).depth; old == target)
+					continue;
+				else
+					move_level(next, old, target);
+
+				for (auto child = node(next).first_child; !child.is_tombstone(); child = node(child).next_sibling)
+					m_stack.push_back(child);
+			}
+		}
+		constexpr void trim_levels() noexcept
+		{
+			while (!m_ends.empty() && m_ends.back() == level_begin(m_ends.size() - 1)) m_ends.pop_back();
+		}
+
+		void handle_create(entity_world &, entity_t e)
+		{
+			/* The node may have been inserted in place of a tombstone past the end of the hierarchy, in which case
+			 * the set is packed to move it to the end of the last level. */
+			if (m_set->offset(e) != nodes_end()) m_set->pack();
+			SEK_ASSERT(m_set->offset(e) == nodes_end(), "Hierarchy levels must not contain tombstones");
+
+			/* New nodes are appended to the last level, then moved to the level of their depth. */
+			if (m_ends.empty()) m_ends.push_back(0);
+			++m_ends.back();
+
+			auto &n = node(e);
+			const auto parent = std::exchange(n.parent, entity_t::tombstone());
+			n.first_child = n.next_sibling = entity_t::tombstone();
+			n.depth = m_ends.size() - 1;
+
+			link(e, parent);
+			move_level(e, n.depth, parent.is_tombstone() ? 0 : node(parent).depth + 1);
+		}
+		void handle_remove(entity_world &, entity_t e)
+		{
+			/* Children of the removed node become root nodes. */
+			while (!node(e).first_child.is_tombstone()) set_parent(node(e).first_child, entity_t::tombstone());
+			unlink(e);
+
+			/* Move the node to the end of the last level, so that swap & pop does not break level order.
+			 * Entities past the last level (if any) are tombstones, thus are never swapped with. */
+			move_level(e, node(e).depth, m_ends.size() - 1);
+			if (const auto pos = m_set->offset(e), last = nodes_end() - 1; pos != last) m_set->swap(pos, last);
+			--m_ends.back();
+			trim_levels();
+		}
+		void handle_lock(entity_world &, entity_t, [[maybe_unused]] bool locked)
+		{
+			SEK_ASSERT(!locked, "Hierarchy nodes must not be locked");
+		}
+		void handle_remap(entity_world &, const entity_remap &table)
+		{
+			/* Offsets of nodes are preserved by the set, thus only links need to be updated. Links to entities that are
+			 * no longer alive are mapped to tombstones. */
+			constexpr auto remap = [](const entity_remap &t, entity_t &e) noexcept
+			{
+				if (!e.is_tombstone()) e = t[e];
+			};
+			for (size_type i = 0; i < nodes_end(); ++i)
+			{
+				auto &n = m_set->get(i);
+				remap(table, n.parent);
+				remap(table, n.first_child);
+				remap(table, n.next_sibling);
+			}
+		}
+
+		component_set<hierarchy_node> *m_set;
+		std::vector<size_type> m_ends;	/* End offsets of hierarchy levels. */
+		std::vector<entity_t> m_stack; /* Nodes pending to be re-leveled. */
+	};
+}	 // namespace sek
@@ -0,0 +1,197 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include "query.hpp"
+
+namespace sek
+{
+	/** @brief Structure used to collect entities that started or stopped matching a query.
+	 *
+	 * Observers are updated from component events of the observed component types and keep the set of currently
+	 * matching entities, thus every entity is recorded at most once in either the entered or the exited set.
+	 * Entities that start and stop matching (or vice versa) between two drains are not recorded at all.
+	 *
+	 * @tparam I Component types included by the observer.
+	 * @tparam E Component types excluded from the observer.
+	 * @tparam Q Component types, entities of which only match while the component is enabled (must be included).
+	 *
+	 * @note Entities matching the query when the observer is created are considered to be already matching.
+	 * @note Exited entities that are no longer alive are dropped when the world is defragmented
+	 * (see `entity_world::defragment`).
+	 * @note The observer must not outlive it's world. */
+	template<typename... I, typename... E, typename... Q>
+	class entity_observer<included_t<I...>, excluded_t<E...>, enabled_t<Q...>>
+	{
+		static_assert((is_in_v<Q, I...> && ...), "Enabled-only component types of an observer must be included");
+		static_assert(!(detail::transient_component<I> || ...) && !(detail::transient_component<E> || ...),
+					  "Observers can not observe transient component types");
+
+	public:
+		typedef std::size_t size_type;
+
+	public:
+		entity_observer(const entity_observer &) = delete;
+		entity_observer &operator=(const entity_observer &) = delete;
+		entity_observer(entity_observer &&) = delete;
+		entity_observer &operator=(entity_observer &&) = delete;
+
+		/** Creates an observer for the specified world. */
+		explicit entity_observer(entity_world &world)
+			: m_world(&world), m_included(&world.template reserve<I>()...), m_excluded(&world.template reserve<E>()...)
+		{
+			for (auto e : world.template view<I...>(excluded_t<E...>{}, optional_t<>{}, enabled_t<Q...>{})) m_matched.insert(e);
+
+			(subscribe_included<I>(), ...);
+			(subscribe_excluded<E>(), ...);
+			(subscribe_enabled<Q>(), ...);
+			m_world->on_remap() += delegate{delegate_func_t<&entity_observer::handle_remap>{}, this};
+		}
+		~entity_observer()
+		{
+			(unsubscribe_included<I>(), ...);
+			(unsubscribe_excluded<E>(), ...);
+			(unsubscribe_enabled<Q>(), ...);
+			m_world->on_remap() -= delegate{delegate_func_t<&entity_observer::handle_remap>{}, this};
+		}
+
+		/** Returns the amount of entities currently matching the observer. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_matched.size(); }
+		/** Checks if the entity currently matches the observer. */
+		[[nodiscard]] constexpr bool contains(entity_t e) const noexcept { return m_matched.contains(e); }
+
+		/** Returns set of entities that started matching the observer since the last drain. */
+		[[nodiscard]] constexpr const entity_set &entered() const noexcept { return m_entered; }
+		/** Returns set of entities that stopped matching the observer since the last drain. */
+		[[nodiscard]] constexpr const entity_set &exited() const noexcept { return m_exited; }
+
+		/** Invokes the functors for every entered & exited entity, then clears both sets.
+		 * @param on_enter Functor invoked for every entity that started matching the observer.
+		 * @param on_exit Functor invoked for every entity that stopped matching the observer. */
+		template<std::invocable<entity_t> FEnter, std::invocable<entity_t> FExit>
+		constexpr void drain(FEnter &&on_enter, FExit &&on_exit)
+		{
+			for (auto e : m_entered) std::invoke(on_enter, e);
+			for (auto e : m_exited) std::invoke(on_exit, e);
+			clear();
+		}
+		/** Clears entered & exited sets of the observer. */
+		constexpr void clear()
+		{
+			m_entered.clear();
+			m_exited.clear();
+		}
+
+	private:
+		template<typename T>
+		[[nodiscard]] constexpr auto *get_included() const noexcept
+		{
+			return std::get<component_set<T> *>(m_included);
+		}
+		template<typename T>
+		[[nodiscard]] constexpr auto *get_excluded() const noexcept
+		{
+			return std::get<component_set<T> *>(m_excluded);
+		}
+
+		/* Checks if the entity matches the observer, ignoring the component of type `T` that is being changed. */
+		template<typename T>
+		[[nodiscard]] constexpr bool accept(entity_t e) const noexcept
+		{
+			constexpr auto accept_included = []<typename U>(type_selector_t<U>, const auto *set, entity_t e)
+			{
+				if (!std::is_same_v<T, U> && !set->contains(e)) return false;
+				if constexpr (is_in_v<U, Q...>)
+					return set->is_enabled(e);
+				else
+					return true;
+			};
+			return (accept_included(type_selector<I>, get_included<I>(), e) && ...) &&
+				   ((std::is_same_v<T, E> || !get_excluded<E>()->contains(e)) && ...);
+		}
+
+		template<typename T>
+		void handle_enter(entity_world &, entity_t e)
+		{
+			if (m_matched.contains(e) || !accept<T>(e)) return;
+
+			m_matched.insert(e);
+			if (m_exited.contains(e))
+				m_exited.erase(e);
+			else
+				m_entered.insert(e);
+		}
+		void handle_exit(entity_world &, entity_t e)
+		{
+			if (!m_matched.contains(e)) return;
+
+			m_matched.erase(e);
+			if (m_entered.contains(e))
+				m_entered.erase(e);
+			else
+				m_exited.insert(e);
+		}
+		template<typename T>
+		void handle_enabled(entity_world &world, entity_t e, bool value)
+		{
+			if (value)
+				handle_enter<T>(world, e);
+			else
+				handle_exit(world, e);
+		}
+		void handle_remap(entity_world &, const entity_remap &table)
+		{
+			/* Dead entities are removed by the remap, thus sets are packed to get rid of the tombstones. */
+			for (auto *set : {&m_matched, &m_entered, &m_exited})
+			{
+				set->remap(table);
+				set->pack();
+			}
+		}
+
+		template<typename T>
+		void subscribe_included()
+		{
+			get_included<T>()->on_create() += delegate{delegate_func_t<&entity_observer::template handle_enter<T>>{}, this};
+			get_included<T>()->on_remove() += delegate{delegate_func_t<&entity_observer::handle_exit>{}, this};
+		}
+		template<typename T>
+		void unsubscribe_included()
+		{
+			get_included<T>()->on_create() -= delegate{delegate_func_t<&entity_observer::template handle_enter<T>>{}, this};
+			get_included<T>()->on_remove() -= delegate{delegate_func_t<&entity_observer::handle_exit>{}, this};
+		}
+		template<typename T>
+		void subscribe_excluded()
+		{
+			get_excluded<T>()->on_create() += delegate{delegate_func_t<&entity_observer::handle_exit>{}, this};
+			get_excluded<T>()->on_remove() += delegate{delegate_func_t<&entity_observer::template handle_enter<T>>{}, this};
+		}
+		template<typename T>
+		void unsubscribe_excluded()
+		{
+			get_excluded<T>()->on_create() -= delegate{delegate_func_t<&entity_observer::handle_exit>{}, this};
+			get_excluded<T>()->on_remove() -= delegate{delegate_func_t<&entity_observer::template handle_enter<T>>{}, this};
+		}
+		template<typename T>
+		void subscribe_enabled()
+		{
+			get_included<T>()->on_enable() += delegate{delegate_func_t<&entity_observer::template handle_enabled<T>>{}, this};
+		}
+		template<typename T>
+		void unsubscribe_enabled()
+		{
+			get_included<T>()->on_enable() -= delegate{delegate_func_t<&entity_observer::template handle_enabled<T>>{}, this};
+		}
+
+		entity_world *m_world;
+		std::tuple<component_set<I> *...> m_included;
+		std::tuple<component_set<E> *...> m_excluded;
+
+		entity_set m_matched; /* Entities currently matching the observer. */
+		entity_set m_entered;
+		entity_set m_exited;
+	};
+}	 // namespace sek
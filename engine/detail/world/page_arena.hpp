@@ -0,0 +1,342 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "fwd.hpp"
+#include "thread_index.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace sek
+{
+	/** @brief Arena used to allocate component pages from large huge-page backed chunks.
+	 *
+	 * Blocks are allocated from chunks of `chunk_size` bytes in size classes matching the requested byte sizes
+	 * (rounded up to `block_align`), since component pages only come in a few distinct sizes. Freed blocks are kept in
+	 * per-class free lists and are re-used by any component type requesting a block of the same size, thus pages of
+	 * different component sets are packed together instead of being scattered across the heap. On Linux, chunks are
+	 * advised to be backed by transparent huge pages (`MADV_HUGEPAGE`).
+	 *
+	 * Allocation & deallocation are synchronized by a lock of the arena, thus component sets of the same world may
+	 * allocate pages from multiple threads.
+	 *
+	 * @note Arena memory is only released when the arena is destroyed. */
+	class page_arena
+	{
+	public:
+		typedef std::size_t size_type;
+
+		/** Size of the smallest block allocated by the arena. Smaller allocations should not use the arena. */
+		constexpr static size_type min_block = 4096;
+		/** Alignment of blocks allocated by the arena. Block sizes are rounded up to a multiple of the alignment. */
+		constexpr static size_type block_align = 64;
+		/** Size of arena chunks (size of a transparent huge page on most platforms). */
+		constexpr static size_type chunk_size = 2 * 1024 * 1024;
+
+	private:
+		struct free_node
+		{
+			free_node *next;
+		};
+		struct size_class
+		{
+			size_type size;
+			free_node *free;
+		};
+
+		[[nodiscard]] constexpr static size_type block_size(size_type n) noexcept
+		{
+			return (std::max(n, min_block) + (block_align - 1)) & ~(block_align - 1);
+		}
+
+		[[nodiscard]] static void *alloc_chunk(size_type n)
+		{
+			auto *ptr = ::operator new(n, std::align_val_t{chunk_size});
+#ifdef __linux__
+			madvise(ptr, n, MADV_HUGEPAGE);
+#endif
+			return ptr;
+		}
+		static void dealloc_chunk(void *ptr) noexcept { ::operator delete(ptr, std::align_val_t{chunk_size}); }
+
+	public:
+		page_arena(const page_arena &) = delete;
+		page_arena &operator=(const page_arena &) = delete;
+		page_arena(page_arena &&) = delete;
+		page_arena &operator=(page_arena &&) = delete;
+
+		page_arena() = default;
+		~page_arena()
+		{
+			for (auto chunk : m_chunks) dealloc_chunk(chunk);
+		}
+
+		/** Allocates a block of at least `n` bytes, aligned to `block_align`.
+		 * @note Blocks that do not fit into a chunk are allocated as separate chunks and are not recycled. */
+		[[nodiscard]] void *allocate(size_type n)
+		{
+			const auto size = block_size(n);
+			if (size > chunk_size) [[unlikely]]
+				return alloc_chunk(n);
+
+			const auto l = std::lock_guard{m_mtx};
+			auto &c = find_class(size);
+			if (auto node = c.free; node != nullptr)
+			{
+				c.free = node->next;
+				return node;
+			}
+			return alloc_block(c.size);
+		}
+		/** Returns a block of `n` bytes previously allocated by the arena. */
+		void deallocate(void *ptr, size_type n) noexcept
+		{
+			if (const auto size = block_size(n); size > chunk_size) [[unlikely]]
+				dealloc_chunk(ptr);
+			else
+			{
+				/* The class of the block was created by it's allocation. */
+				const auto l = std::lock_guard{m_mtx};
+				push_free(*lookup_class(size), ptr);
+			}
+		}
+
+	private:
+		[[nodiscard]] size_class *lookup_class(size_type size) noexcept
+		{
+			const auto pos = std::ranges::find(m_classes, size, &size_class::size);
+			return pos != m_classes.end() ? &*pos : nullptr;
+		}
+		[[nodiscard]] size_class &find_class(size_type size)
+		{
+			if (const auto c = lookup_class(size); c != nullptr) [[likely]]
+				return *c;
+
+			/* Classes are kept sorted by size in descending order, so that chunk tails are split into the largest
+			 * blocks first. References to classes are only held while the lock is acquired. */
+			const auto pos = std::ranges::find_if(m_classes, [size](auto &c) { return c.size < size; });
+			return *m_classes.insert(pos, size_class{size, nullptr});
+		}
+
+		static void push_free(size_class &c, void *ptr) noexcept
+		{
+			const auto node = static_cast<free_node *>(ptr);
+			node->next = c.free;
+			c.free = node;
+		}
+		[[nodiscard]] void *alloc_block(size_type n)
+		{
+			if (static_cast<size_type>(m_end - m_top) < n) [[unlikely]]
+			{
+				/* Split the remainder of the current chunk into free blocks of existing classes. All block sizes
+				 * are multiples of `block_align`, thus the remainder is always aligned. */
+				for (auto &c : m_classes)
+					while (static_cast<size_type>(m_end - m_top) >= c.size)
+					{
+						push_free(c, m_top);
+						m_top += c.size;
+					}
+
+				m_chunks.push_back(alloc_chunk(chunk_size));
+				m_top = static_cast<std::byte *>(m_chunks.back());
+				m_end = m_top + chunk_size;
+			}
+
+			const auto result = m_top;
+			m_top += n;
+			return result;
+		}
+
+		std::mutex m_mtx;
+		std::vector<size_class> m_classes; /* Size classes in descending order of size. */
+		std::vector<void *> m_chunks;
+		std::byte *m_top = nullptr;
+		std::byte *m_end = nullptr;
+	};
+
+	/** @brief Linear arena used to allocate storage of transient (per-frame) components of a world.
+	 *
+	 * Every thread allocating from the arena is assigned a region of blocks, memory is bump-allocated from the region
+	 * of the calling thread without synchronization. At the end of a frame (see `next_frame`) all regions are
+	 * rewound to the start of their first block in `O(1)` per region, without running any destructors. Blocks are
+	 * retained between frames and are released together with the arena.
+	 *
+	 * Every world owns a separate frame arena, thus ending a frame of one world does not affect transient components
+	 * of other worlds. Regions of exited threads are inherited by threads re-using their index (see
+	 * `detail::thread_index`), thus transient components allocated by a thread stay valid until the end of the frame.
+	 *
+	 * @warning Memory allocated during a frame is invalidated once the frame ends.
+	 * @warning `next_frame` must not be called concurrently with allocations from the arena. */
+	class frame_arena
+	{
+	public:
+		typedef std::size_t size_type;
+
+		/** Size of blocks allocated by frame arenas. */
+		constexpr static size_type block_size = 256 * 1024;
+		/** Maximum alignment supported by frame arenas. */
+		constexpr static size_type max_align = 64;
+
+	private:
+		[[nodiscard]] static void *alloc_block(size_type n) { return ::operator new(n, std::align_val_t{max_align}); }
+		static void dealloc_block(void *ptr) noexcept { ::operator delete(ptr, std::align_val_t{max_align}); }
+
+		/* Blocks of a single thread. */
+		struct region
+		{
+			region() noexcept = default;
+			region(const region &) = delete;
+			region &operator=(const region &) = delete;
+			~region()
+			{
+				for (auto block : blocks) dealloc_block(block);
+				for (auto block : large) dealloc_block(block);
+			}
+
+			[[nodiscard]] void *allocate(size_type n, size_type align)
+			{
+				/* Allocations that do not fit into a single block are allocated separately. */
+				if (n + align > block_size) [[unlikely]]
+				{
+					large.reserve(large.size() + 1);
+					return large.emplace_back(alloc_block(n));
+				}
+
+				for (;;)
+				{
+					const auto pos = (top + (align - 1)) & ~(align - 1);
+					if (block < blocks.size() && pos + n <= block_size)
+					{
+						top = pos + n;
+						return static_cast<std::byte *>(blocks[block]) + pos;
+					}
+
+					/* Move to the next retained block or allocate a new one. */
+					if (top != 0) ++block;
+					if (block == blocks.size())
+					{
+						blocks.reserve(blocks.size() + 1);
+						blocks.push_back(alloc_block(block_size));
+					}
+					top = 0;
+				}
+			}
+			void reset() noexcept
+			{
+				for (auto ptr : large) dealloc_block(ptr);
+				large.clear();
+				block = 0;
+				top = 0;
+			}
+
+			std::vector<void *> blocks;
+			std::vector<void *> large;
+			size_type block = 0;
+			size_type top = 0;
+		};
+
+	public:
+		frame_arena(const frame_arena &) = delete;
+		frame_arena &operator=(const frame_arena &) = delete;
+
+		frame_arena() noexcept = default;
+
+		/** Allocates `n` bytes aligned to `align` (at most `max_align`) from the region of the calling thread. */
+		[[nodiscard]] void *allocate(size_type n, size_type align)
+		{
+			return m_regions.local().allocate(n, align);
+		}
+		/** Ends the current frame, invalidating all memory allocated from the arena. */
+		void next_frame() noexcept
+		{
+			m_regions.for_each([](region &r) { r.reset(); });
+		}
+
+	private:
+		detail::thread_slots<region> m_regions;
+	};
+
+	namespace detail
+	{
+		/* Defined in world.hpp, since the world is incomplete at this point. */
+		[[nodiscard]] inline page_arena &world_arena(entity_world &world);
+		[[nodiscard]] inline frame_arena &world_frame_arena(entity_world &world);
+	}	 // namespace detail
+
+	/** @brief Allocator used to allocate component pages from a `page_arena`.
+	 *
+	 * Allocations smaller than `page_arena::min_block` bytes or of over-aligned types are forwarded to the global
+	 * `operator new`. Component
+	 * sets construct page allocators from the page arena of their parent world. Use `page_allocator` as
+	 * `component_traits<T>::allocator_type` to enable arena allocation for a component type, or define
+	 * `SEK_WORLD_PAGE_ARENA` to make it the default for all component types. */
+	template<typename T>
+	class page_allocator
+	{
+		template<typename>
+		friend class page_allocator;
+
+	public:
+		typedef T value_type;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+		typedef std::false_type is_always_equal;
+
+	public:
+		/** Initializes an allocator without an arena (all allocations are forwarded to `operator new`). */
+		constexpr page_allocator() noexcept = default;
+		/** Initializes an allocator for the specified arena. */
+		constexpr page_allocator(page_arena &arena) noexcept : m_arena(&arena) {}
+		/** Initializes an allocator for the page arena of the specified world. */
+		page_allocator(entity_world &world) : page_allocator(detail::world_arena(world)) {}
+		template<typename U>
+		constexpr page_allocator(const page_allocator<U> &other) noexcept : m_arena(other.m_arena)
+		{
+		}
+
+		[[nodiscard]] T *allocate(size_type n)
+		{
+			if (const auto bytes = n * sizeof(T); use_arena(bytes))
+				return static_cast<T *>(m_arena->allocate(bytes));
+			else
+				return static_cast<T *>(::operator new(bytes, std::align_val_t{alignof(T)}));
+		}
+		void deallocate(T *ptr, size_type n) noexcept
+		{
+			if (const auto bytes = n * sizeof(T); use_arena(bytes))
+				m_arena->deallocate(ptr, bytes);
+			else
+				::operator delete(ptr, std::align_val_t{alignof(T)});
+		}
+
+		template<typename U>
+		[[nodiscard]] constexpr bool operator==(const page_allocator<U> &other) const noexcept
+		{
+			return m_arena == other.m_arena;
+		}
+
+	private:
+		[[nodiscard]] constexpr bool use_arena(size_type bytes) const noexcept
+		{
+			return m_arena != nullptr && bytes >= page_arena::min_block && alignof(T) <= page_arena::block_align;
+		}
+
+		page_arena *m_arena = nullptr;
+	};
+}	 // namespace sek
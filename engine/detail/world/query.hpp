@@ -16,11 +16,13 @@ namespace sek
 	 * @tparam I Component types included by the query.
 	 * @tparam E Component types excluded from the query.
 	 * @tparam P Component types optional to the query (must be included).
+	 * @tparam Q Component types, entities of which are only accepted while the component is enabled (must be owned or
+	 * included).
 	 *
 	 * @note Excluded components must not be the same as owned, included and optional.
 	 * @note Owning queries can only be created for non-constant worlds. */
-	template<typename W, typename... O, typename... I, typename... E, typename... P>
-	class entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>>
+	template<typename W, typename... O, typename... I, typename... E, typename... P, typename... Q>
+	class entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>
 	{
 		friend class entity_world;
 
@@ -32,19 +34,23 @@ namespace sek
 		constexpr static bool is_inc = is_in_v<std::remove_cv_t<T>, std::remove_cv_t<I>...>;
 		template<typename T>
 		constexpr static bool is_opt = is_in_v<std::remove_cv_t<T>, std::remove_cv_t<P>...>;
+		template<typename T>
+		constexpr static bool is_tag = detail::bitset_component<std::remove_cv_t<T>>;
 
 		static_assert(!(is_own<E> || ...), "Excluded component types can not be owned");
 		static_assert(!(is_inc<E> || ...), "Excluded component types can not be included");
 		static_assert(!(is_opt<E> || ...), "Excluded component types can not be optional");
 
 		template<typename... Ts>
-		using own_query = entity_query<W, owned_t<O..., Ts...>, included_t<I...>, excluded_t<E...>, optional_t<P...>>;
+		using own_query = entity_query<W, owned_t<O..., Ts...>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>;
+		template<typename... Ts>
+		using include_query = entity_query<W, owned_t<O...>, included_t<I..., Ts...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>;
 		template<typename... Ts>
-		using include_query = entity_query<W, owned_t<O...>, included_t<I..., Ts...>, excluded_t<E...>, optional_t<P...>>;
+		using exclude_query = entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E..., Ts...>, optional_t<P...>, enabled_t<Q...>>;
 		template<typename... Ts>
-		using exclude_query = entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E..., Ts...>, optional_t<P...>>;
+		using optional_query = entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P..., Ts...>, enabled_t<Q...>>;
 		template<typename... Ts>
-		using optional_query = entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P..., Ts...>>;
+		using enabled_query = entity_query<W, owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q..., Ts...>>;
 
 	public:
 		entity_query() = delete;
@@ -79,6 +85,16 @@ namespace sek
 		{
 			return optional_query<transfer_cv_t<W, Cs>...>{*m_parent};
 		}
+		/** Returns a new query with `Cs` components added to the enabled-only components list. Entities, components
+		 * of which are disabled for any of the enabled-only types will be skipped.
+		 * @return New query instance.
+		 * @note Enabled-only components must be owned or included. */
+		template<typename... Cs>
+		constexpr auto enabled() const
+		{
+			static_assert(((is_own<Cs> || is_inc<Cs>) && ...), "Enabled-only component types must be owned or included");
+			return enabled_query<transfer_cv_t<W, Cs>...>{*m_parent};
+		}
 
 		/** Returns a new query with `Cs` components added to the owned components list.
 		 * @return New query instance.
@@ -91,6 +107,7 @@ namespace sek
 			return own_query<Cs...>{*m_parent};
 		}
 		/** Returns a component collection made using this query. See `component_collection`.
+		 * Component sets & the collection handler are resolved once and cached by the world.
 		 * @note Collections are only allowed for non-const worlds.
 		 * @note Collections sort owned components and track any modifications to component sets.
 		 * @note If any component from the owned list is locked, entities of those components will be excluded from
@@ -98,29 +115,58 @@ namespace sek
 		[[nodiscard]] constexpr auto collection() const
 		{
 			static_assert(!is_read_only, "Collections are not available for read-only queries");
-			using handler_t = detail::collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>>;
+			static_assert(!((is_tag<O> || ...) || (is_tag<I> || ...) || (is_tag<E> || ...) || (is_tag<P> || ...)),
+						  "Collections can not use bitset tag types");
+			using handler_t = detail::collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>>;
 
-			// clang-format off
-			return component_collection<owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>>{
-				handler_t::make_handler(*m_parent),
-				m_parent->template storage<O>()...,
-				m_parent->template storage<I>()...,
-				m_parent->template storage<P>()...
-			};
-			// clang-format on
+			using collection_t = component_collection<owned_t<O...>, included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>;
+
+			const auto handler = m_parent->template cached_handler<handler_t>();
+			const auto storage = m_parent->template cached_storage<O..., I..., P...>();
+			return std::apply([handler](auto *...sets) { return collection_t{handler, sets...}; }, storage);
 		}
 
 		/** Returns a component view made using this query. See `component_view`.
-		 * @note Views ignore owned components. */
+		 * Component sets of non-const worlds are resolved once and cached by the world.
+		 * @note Views ignore owned components.
+		 * @note Views may be constructed from multiple threads at once, as long as component sets of all their
+		 * component types already exist. */
 		[[nodiscard]] constexpr auto view() const
 		{
+			static_assert((is_inc<Q> && ...), "Enabled-only component types of a view must be included");
+
+			using view_t = component_view<included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>;
+
+			if constexpr (!is_read_only)
+				return std::apply([](auto *...sets) { return view_t{sets...}; }, m_parent->template cached_storage<I..., E..., P...>());
+			else
+			{
+				// clang-format off
+				return view_t{
+					m_parent->template storage<I>()...,
+					m_parent->template storage<E>()...,
+					m_parent->template storage<P>()...
+				};
+				// clang-format on
+			}
+		}
+
+		/** Returns an observer made using this query. See `entity_observer`.
+		 * The observer is constructed in-place, and thus must be initialized directly from the result.
+		 * @note Observers are only allowed for non-const worlds.
+		 * @note Owned components are treated as included.
+		 * @note Requires `observer.hpp` to be included. */
+		[[nodiscard]] constexpr auto observer() const
+		{
+			static_assert(!is_read_only, "Observers are not available for read-only queries");
+			static_assert(!((is_tag<O> || ...) || (is_tag<I> || ...) || (is_tag<E> || ...)), "Observers can not use bitset tag types");
+
 			// clang-format off
-			return component_view<included_t<I...>, excluded_t<E...>, optional_t<P...>>{
-				m_parent->template storage<I>()...,
-				m_parent->template storage<E>()...,
-				m_parent->template storage<P>()...
-			};
+			using observer_t = entity_observer<included_t<std::remove_cv_t<O>..., std::remove_cv_t<I>...>,
+											   excluded_t<std::remove_cv_t<E>...>,
+											   enabled_t<std::remove_cv_t<Q>...>>;
 			// clang-format on
+			return observer_t{*m_parent};
 		}
 
 	private:
@@ -128,28 +174,31 @@ namespace sek
 	};
 
 	template<typename W>
-	entity_query(W &) -> entity_query<W, owned_t<>, included_t<>, excluded_t<>, optional_t<>>;
+	entity_query(W &) -> entity_query<W, owned_t<>, included_t<>, excluded_t<>, optional_t<>, enabled_t<>>;
 	template<typename W>
-	entity_query(const W &) -> entity_query<const W, owned_t<>, included_t<>, excluded_t<>, optional_t<>>;
+	entity_query(const W &) -> entity_query<const W, owned_t<>, included_t<>, excluded_t<>, optional_t<>, enabled_t<>>;
 
 	constexpr auto entity_world::query() noexcept { return entity_query{*this}; }
 	constexpr auto entity_world::query() const noexcept { return entity_query{*this}; }
 
-	template<typename... I, typename... E, typename... P>
-	constexpr auto entity_world::view(excluded_t<E...>, optional_t<P...>) noexcept
+	template<typename... I, typename... E, typename... P, typename... Q>
+	constexpr auto entity_world::view(excluded_t<E...>, optional_t<P...>, enabled_t<Q...>) noexcept
 	{
-		return query().template include<I...>().template exclude<E...>().template optional<P...>().view();
+		return query().template include<I...>().template exclude<E...>().template optional<P...>().template enabled<Q...>().view();
 	}
-	template<typename... I, typename... E, typename... P>
-	constexpr auto entity_world::view(excluded_t<E...>, optional_t<P...>) const noexcept
+	template<typename... I, typename... E, typename... P, typename... Q>
+	constexpr auto entity_world::view(excluded_t<E...>, optional_t<P...>, enabled_t<Q...>) const noexcept
 	{
-		return query().template include<I...>().template exclude<E...>().template optional<P...>().view();
+		return query().template include<I...>().template exclude<E...>().template optional<P...>().template enabled<Q...>().view();
 	}
 
-	template<typename... O, typename... I, typename... E, typename... P>
-	constexpr auto entity_world::collection(included_t<I...>, excluded_t<E...>, optional_t<P...>) noexcept
+	template<typename... O, typename... I, typename... E, typename... P, typename... Q>
+	constexpr auto entity_world::collection(included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>) noexcept
 	{
-		return query().template own<O...>().template include<I...>().template exclude<E...>().template optional<P...>().collection();
+		// clang-format off
+		return query().template own<O...>().template include<I...>().template exclude<E...>()
+					  .template optional<P...>().template enabled<Q...>().collection();
+		// clang-format on
 	}
 
 }	 // namespace sek
\ No newline at end of file
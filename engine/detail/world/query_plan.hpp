@@ -0,0 +1,75 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <utility>
+
+#include "component_set.hpp"
+
+namespace sek::detail
+{
+	/* Statistics-based planning of queries, shared by `component_view` and `dynamic_query`. Statistics are sampled
+	 * from dense arrays of component sets, thus planning is `O(n * m)` where `n` is the amount of samples and `m` is
+	 * the amount of tests. */
+	struct query_plan
+	{
+		typedef std::size_t size_type;
+
+		/* Minimum size of the largest included set, for which queries are planned using sampled statistics. */
+		constexpr static size_type plan_threshold = 1024;
+		/* Maximum amount of entities sampled from a set while planning. */
+		constexpr static size_type sample_count = 32;
+
+		template<typename F>
+		constexpr static void for_each_sample(const generic_component_set *set, F &&f)
+		{
+			const auto n = set->size();
+			for (size_type i = 0, step = std::max<size_type>(n / sample_count, 1); i < n; i += step) f(set->data()[i]);
+		}
+
+		/* Returns the candidate main set with the lowest estimated iteration cost. Every entry of the dense array is
+		 * iterated, while only live entities (not tombstones) are tested against the rest of the `test_count` tests.
+		 * Null candidates are skipped. */
+		[[nodiscard]] constexpr static const generic_component_set *select_main(
+			std::span<const generic_component_set *const> sets, size_type test_count) noexcept
+		{
+			const generic_component_set *result = nullptr;
+			auto best_cost = std::numeric_limits<size_type>::max();
+			for (auto set : sets)
+			{
+				if (set == nullptr) continue;
+
+				size_type samples = 0, live = 0;
+				for_each_sample(set, [&](entity_t e) { ++samples, live += !e.is_tombstone(); });
+
+				const auto live_est = samples == 0 ? 0 : set->size() * live / samples;
+				if (const auto cost = set->size() + live_est * (test_count - 1); cost < best_cost)
+				{
+					best_cost = cost;
+					result = set;
+				}
+			}
+			return result;
+		}
+
+		/* Orders tests by the amount of sampled entities of the main set they reject, most selective first.
+		 * `stats` contains zero-initialized rejection counts & ids of the tests, `test(id, e)` evaluates a test. */
+		template<typename Id, typename F>
+		constexpr static void order_tests(const generic_component_set *main, std::span<std::pair<size_type, Id>> stats, F &&test)
+		{
+			for_each_sample(main,
+							[&](entity_t e)
+							{
+								if (e.is_tombstone()) [[unlikely]]
+									return;
+								for (auto &stat : stats) stat.first += !test(stat.second, e);
+							});
+			std::stable_sort(stats.begin(), stats.end(), [](auto &a, auto &b) { return a.first > b.first; });
+		}
+	};
+}	 // namespace sek::detail
@@ -0,0 +1,193 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Structure used to store `(R, target)` relation pairs between entities of a world.
+	 *
+	 * Every pair links a source entity to a target entity. Relations keep both the forward (source -> targets) and
+	 * the reverse (target -> sources) index as flat adjacency lists, thus memory used by the relation is proportional
+	 * to the amount of pairs. Finding all sources of a target is `O(1)`, insertion & removal of pairs are `O(n)`
+	 * where `n` is the amount of pairs of the source & target entities. When an entity is destroyed, all pairs
+	 * referencing it (either as a source or as a target) are removed in `O(n * m)`, where `n` is the amount of pairs
+	 * of the entity and `m` is the amount of pairs of the other entity of every pair.
+	 *
+	 * @tparam R Type used to identify the relation (ex. `struct child_of {};`).
+	 * @note The relation must not outlive it's world.
+	 * @note Pairs are only removed automatically when entities are destroyed via `entity_world::destroy`. Pairs of
+	 * entities released via `entity_world::release` or by clearing the world must be removed manually (see `erase`
+	 * and `clear`). */
+	template<typename R>
+	class entity_relation
+	{
+		static_assert(!detail::transient_component<R>, "Relation types can not be transient");
+
+		using index_t = dense_map<entity_t, std::vector<entity_t>>;
+
+	public:
+		typedef R relation_type;
+		typedef std::size_t size_type;
+
+	public:
+		entity_relation(const entity_relation &) = delete;
+		entity_relation &operator=(const entity_relation &) = delete;
+		entity_relation(entity_relation &&) = delete;
+		entity_relation &operator=(entity_relation &&) = delete;
+
+		/** Binds the relation to the specified world. */
+		explicit entity_relation(entity_world &world) : m_world(&world)
+		{
+			m_world->on_destroy() += delegate{delegate_func_t<&entity_relation::handle_destroy>{}, this};
+			m_world->on_remap() += delegate{delegate_func_t<&entity_relation::handle_remap>{}, this};
+		}
+		~entity_relation()
+		{
+			m_world->on_destroy() -= delegate{delegate_func_t<&entity_relation::handle_destroy>{}, this};
+			m_world->on_remap() -= delegate{delegate_func_t<&entity_relation::handle_remap>{}, this};
+		}
+
+		/** Returns the total amount of pairs of the relation. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_size; }
+		/** Checks if the relation is empty. */
+		[[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+
+		/** Checks if the relation contains the `(source, target)` pair. */
+		[[nodiscard]] constexpr bool contains(entity_t source, entity_t target) const noexcept
+		{
+			const auto iter = m_targets.find(source);
+			return iter != m_targets.end() && std::ranges::find(iter->second, target) != iter->second.end();
+		}
+
+		/** Returns span of entities targeted by the source entity. */
+		[[nodiscard]] constexpr std::span<const entity_t> targets(entity_t source) const noexcept
+		{
+			return get_span(m_targets, source);
+		}
+		/** Returns span of entities targeting the target entity. */
+		[[nodiscard]] constexpr std::span<const entity_t> sources(entity_t target) const noexcept
+		{
+			return get_span(m_sources, target);
+		}
+
+		/** Invokes the functor for every source of the target entity that belongs to the specified view or collection.
+		 * @param target Target entity of the relation.
+		 * @param filter View or collection used to filter sources of the target.
+		 * @param f Functor invoked with every accepted source entity. */
+		template<typename V, std::invocable<entity_t> F>
+		constexpr void for_each_source(entity_t target, const V &filter, F &&f) const
+		{
+			for (auto source : sources(target))
+				if (filter.contains(source)) std::invoke(f, source);
+		}
+
+		/** Adds a `(source, target)` pair to the relation.
+		 * @return `true` if the pair was inserted, `false` if it already exists. */
+		constexpr bool insert(entity_t source, entity_t target)
+		{
+			if (contains(source, target)) return false;
+			m_targets[source].push_back(target);
+			m_sources[target].push_back(source);
+			++m_size;
+			return true;
+		}
+		/** Removes a `(source, target)` pair from the relation.
+		 * @return `true` if the pair was removed, `false` if it does not exist. */
+		constexpr bool erase(entity_t source, entity_t target)
+		{
+			if (!erase_link(m_targets, source, target)) return false;
+			erase_link(m_sources, target, source);
+			--m_size;
+			return true;
+		}
+		/** Removes all pairs referencing the entity, either as a source or as a target. */
+		constexpr void erase(entity_t e)
+		{
+			erase_all(m_targets, m_sources, e);
+			erase_all(m_sources, m_targets, e);
+		}
+
+		/** Removes all pairs of the relation. */
+		constexpr void clear()
+		{
+			m_targets.clear();
+			m_sources.clear();
+			m_size = 0;
+		}
+
+	private:
+		[[nodiscard]] constexpr static std::span<const entity_t> get_span(const index_t &index, entity_t e) noexcept
+		{
+			if (const auto iter = index.find(e); iter != index.end()) [[likely]]
+				return {iter->second.data(), iter->second.size()};
+			else
+				return {};
+		}
+		constexpr static bool erase_link(index_t &index, entity_t key, entity_t value)
+		{
+			const auto iter = index.find(key);
+			if (iter == index.end()) return false;
+
+			/* Adjacency lists are unordered, thus swap & pop the link. */
+			auto &list = iter->second;
+			const auto pos = std::ranges::find(list, value);
+			if (pos == list.end()) return false;
+			*pos = list.back();
+			list.pop_back();
+
+			/* Remove index entries that no longer reference any entities. */
+			if (list.empty()) index.erase(iter);
+			return true;
+		}
+		constexpr void erase_all(index_t &index, index_t &reverse, entity_t e)
+		{
+			if (const auto iter = index.find(e); iter != index.end())
+			{
+				for (auto other : iter->second) erase_link(reverse, other, e);
+				m_size -= iter->second.size();
+				index.erase(iter);
+			}
+		}
+
+		void handle_destroy(entity_world &, entity_t e) { erase(e); }
+		void handle_remap(entity_world &, const entity_remap &table)
+		{
+			/* Both indices are rebuilt from the forward one. Pairs of entities that are no longer alive
+			 * (ex. released via `entity_world::release`) are dropped, since their indices may have been re-used.
+			 * Versions are compared as well, thus stale entities of re-used indices are dropped too. */
+			index_t targets, sources;
+			size_type size = 0;
+			for (auto &entry : m_targets)
+			{
+				if (!table.contains(entry.first)) continue;
+
+				const auto source = table[entry.first];
+				for (auto old : entry.second)
+					if (table.contains(old))
+					{
+						const auto target = table[old];
+						targets[source].push_back(target);
+						sources[target].push_back(source);
+						++size;
+					}
+			}
+
+			m_targets = std::move(targets);
+			m_sources = std::move(sources);
+			m_size = size;
+		}
+
+		entity_world *m_world;
+		index_t m_targets; /* source -> targets */
+		index_t m_sources; /* target -> sources */
+		size_type m_size = 0;
+	};
+}	 // namespace sek
@@ -0,0 +1,251 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Helper used to publish immutable snapshots of a component set for concurrent readers.
+	 *
+	 * The writer (ex. simulation thread) calls `publish` at the end of a frame, which creates a new snapshot of the
+	 * component set. Snapshots are split into pages of `component_traits<C>::page_size` components, and only pages
+	 * that changed since the previous snapshot are copied, while the rest are shared between snapshots.
+	 * Readers (ex. render thread) call `acquire` to get the last published snapshot, which stays valid for as long
+	 * as the reader holds on to it, regardless of any further publishes. Snapshots (and their pages) are reclaimed
+	 * once the last reader releases them.
+	 *
+	 * A page is copied if any of it's components were created, modified or removed since the previous snapshot, which
+	 * is tracked by offsets of the component events. If entities of the set were moved in bulk (ex. the set was
+	 * sorted or packed, see `layout_version`), entities of all pages are compared instead.
+	 *
+	 * @tparam C Component type to publish. Must be copy-constructible.
+	 *
+	 * @note Modification of components is only tracked when done through type-specific functions of the
+	 * world or component set (ex. `replace`, `apply`). Components modified in-place must be reported via `touch`.
+	 * @note `publish` and `touch` must only be called by the thread that modifies the component set.
+	 * @note The snapshot helper must not outlive it's world. Snapshots acquired from it may. */
+	template<typename C>
+	class component_snapshot
+	{
+		static_assert(std::is_copy_constructible_v<C>, "Published component type must be copy-constructible");
+		static_assert(!detail::transient_component<C>, "Transient component types can not be published");
+
+		constexpr static std::size_t page_size = component_traits<C>::page_size;
+
+	public:
+		typedef std::size_t size_type;
+
+		/** @brief Immutable snapshot of a component set. */
+		class frame
+		{
+			friend class component_snapshot;
+
+			struct page
+			{
+				std::vector<entity_t> entities;
+				std::vector<C> components;
+			};
+			/* Position of an entity within the snapshot. */
+			struct slot
+			{
+				size_type page = std::numeric_limits<size_type>::max();
+				size_type pos = 0;
+			};
+
+		public:
+			/** Returns the amount of components within the snapshot. */
+			[[nodiscard]] constexpr size_type size() const noexcept { return m_size; }
+			/** Checks if the snapshot is empty. */
+			[[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+			/** Returns the sequence number of the snapshot (incremented on every publish). */
+			[[nodiscard]] constexpr size_type version() const noexcept { return m_version; }
+
+			/** Invokes the functor for every entity & component of the snapshot (in the order of the component set). */
+			template<std::invocable<entity_t, const C &> F>
+			void for_each(F &&f) const
+			{
+				for (auto &p : m_pages)
+					for (size_type i = 0; i < p->entities.size(); ++i) std::invoke(f, p->entities[i], p->components[i]);
+			}
+
+			/** Returns pointer to the component of the entity within the snapshot, or `nullptr` if the entity did
+			 * not have a component at the time of the snapshot.
+			 * @note The first lookup builds an index of the snapshot in `O(n)`, further lookups are `O(1)`.
+			 * Lookups can be done from multiple threads. */
+			[[nodiscard]] const C *find(entity_t e) const
+			{
+				std::call_once(m_index_flag, [this]() { build_index(); });
+
+				const auto idx = e.index().value();
+				if (e.is_tombstone() || idx >= m_index.size()) [[unlikely]]
+					return nullptr;
+
+				const auto s = m_index[idx];
+				if (s.page >= m_pages.size()) return nullptr;
+
+				const auto &p = *m_pages[s.page];
+				return p.entities[s.pos].value() == e.value() ? &p.components[s.pos] : nullptr;
+			}
+			/** Checks if the entity had a component at the time of the snapshot. See `find`. */
+			[[nodiscard]] bool contains(entity_t e) const { return find(e) != nullptr; }
+
+		private:
+			void build_index() const
+			{
+				for (size_type i = 0; i < m_pages.size(); ++i)
+					for (size_type j = 0; j < m_pages[i]->entities.size(); ++j)
+					{
+						const auto idx = m_pages[i]->entities[j].index().value();
+						if (idx >= m_index.size()) m_index.resize(idx + 1);
+						m_index[idx] = slot{i, j};
+					}
+			}
+
+			std::vector<std::shared_ptr<const page>> m_pages;
+			size_type m_size = 0;
+			size_type m_version = 0;
+
+			mutable std::once_flag m_index_flag;
+			mutable std::vector<slot> m_index; /* Entity index -> position within the snapshot, built on first lookup. */
+		};
+
+		typedef std::shared_ptr<const frame> frame_ptr;
+
+	public:
+		component_snapshot(const component_snapshot &) = delete;
+		component_snapshot &operator=(const component_snapshot &) = delete;
+		component_snapshot(component_snapshot &&) = delete;
+		component_snapshot &operator=(component_snapshot &&) = delete;
+
+		/** Creates a snapshot helper for components of type `C` of the specified world.
+		 * @note The initial (empty) snapshot is published on creation. */
+		explicit component_snapshot(entity_world &world)
+			: m_set(&world.template reserve<C>()), m_published(m_last)
+		{
+			m_set->on_create() += delegate{delegate_func_t<&component_snapshot::handle_event>{}, this};
+			m_set->on_modify() += delegate{delegate_func_t<&component_snapshot::handle_event>{}, this};
+			m_set->on_remove() += delegate{delegate_func_t<&component_snapshot::handle_remove>{}, this};
+			world.on_remap() += delegate{delegate_func_t<&component_snapshot::handle_remap>{}, this};
+		}
+		~component_snapshot()
+		{
+			m_set->on_create() -= delegate{delegate_func_t<&component_snapshot::handle_event>{}, this};
+			m_set->on_modify() -= delegate{delegate_func_t<&component_snapshot::handle_event>{}, this};
+			m_set->on_remove() -= delegate{delegate_func_t<&component_snapshot::handle_remove>{}, this};
+			m_set->world().on_remap() -= delegate{delegate_func_t<&component_snapshot::handle_remap>{}, this};
+		}
+
+		/** Returns the last published snapshot.
+		 * @note This function can be called from any thread. */
+		[[nodiscard]] frame_ptr acquire() const noexcept { return m_published.load(std::memory_order_acquire); }
+
+		/** Marks component of the entity as modified, so that it's page will be copied on the next publish. */
+		void touch(entity_t e)
+		{
+			if (m_set->contains(e)) [[likely]]
+				mark_dirty(m_set->offset(e));
+		}
+		/** Forces all pages to be copied on the next publish. */
+		constexpr void invalidate() noexcept { m_invalid = true; }
+
+		/** Publishes a new snapshot of the component set. Pages that did not change since the previous snapshot
+		 * are shared with it. */
+		void publish()
+		{
+			/* The previous snapshot is only read by the writer thread here, thus no need to go through `acquire`. */
+			const auto &prev = *m_last;
+			const auto pages = (m_set->size() + page_size - 1) / page_size;
+
+			/* Pages of components are marked by events, entities of other pages only change if the set was
+			 * re-ordered, in which case all pages are compared. */
+			m_dirty.resize(pages, false);
+			const auto reordered = m_set->layout_version() != m_layout;
+
+			auto next = std::make_shared<frame>();
+			next->m_pages.reserve(pages);
+			next->m_version = prev.m_version + 1;
+			for (size_type i = 0; i < pages; ++i)
+			{
+				const auto first = i * page_size;
+				const auto last = std::min(first + page_size, m_set->size());
+
+				const auto shared = !(m_invalid || m_dirty[i]) && i < prev.m_pages.size();
+				if (shared && (!reordered || same_entities(*prev.m_pages[i], first, last)))
+					next->m_pages.push_back(prev.m_pages[i]);
+				else
+					next->m_pages.push_back(copy_page(first, last));
+				next->m_size += next->m_pages.back()->entities.size();
+			}
+
+			std::fill(m_dirty.begin(), m_dirty.end(), false);
+			m_layout = m_set->layout_version();
+			m_invalid = false;
+			m_last = next;
+			m_published.store(std::move(next), std::memory_order_release);
+		}
+
+	private:
+		void mark_dirty(size_type offset)
+		{
+			const auto p = offset / page_size;
+			if (p >= m_dirty.size()) m_dirty.resize(p + 1, false);
+			m_dirty[p] = true;
+		}
+
+		[[nodiscard]] bool same_entities(const typename frame::page &p, size_type first, size_type last) const noexcept
+		{
+			/* Pages only store alive entities, thus tombstones are skipped during the comparison. */
+			auto pos = p.entities.begin();
+			for (auto i = first; i < last; ++i)
+				if (const auto e = m_set->at(i); !e.is_tombstone())
+				{
+					if (pos == p.entities.end() || *pos != e) return false;
+					++pos;
+				}
+			return pos == p.entities.end();
+		}
+		[[nodiscard]] std::shared_ptr<const typename frame::page> copy_page(size_type first, size_type last) const
+		{
+			auto result = std::make_shared<typename frame::page>();
+			result->entities.reserve(last - first);
+			result->components.reserve(last - first);
+			for (auto i = first; i < last; ++i)
+				if (const auto e = m_set->at(i); !e.is_tombstone()) [[likely]]
+				{
+					result->entities.push_back(e);
+					result->components.push_back(m_set->get(i));
+				}
+			return result;
+		}
+
+		void handle_event(entity_world &, entity_t e) { touch(e); }
+		void handle_remove(entity_world &, entity_t e)
+		{
+			/* Removal may move the last entity of the set to the offset of the removed one. */
+			touch(e);
+			if (const auto n = m_set->size(); n != 0) [[likely]]
+				mark_dirty(n - 1);
+		}
+		/* Entities of published pages are not remapped, which invalidates them since the entities changed. */
+		void handle_remap(entity_world &, const entity_remap &) { invalidate(); }
+
+		component_set<C> *m_set;
+		std::vector<bool> m_dirty; /* Pages modified since the last publish. */
+		size_type m_layout = m_set->layout_version();
+		bool m_invalid = false;
+
+		std::shared_ptr<const frame> m_last = std::make_shared<const frame>();
+		std::atomic<std::shared_ptr<const frame>> m_published;
+	};
+}	 // namespace sek
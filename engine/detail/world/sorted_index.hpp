@@ -0,0 +1,236 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Secondary index of components, sorted by a key extracted from a component field.
+	 *
+	 * The index keeps a sorted array of `(key, entity)` pairs, which is updated from creation, modification and
+	 * removal events of the component set. Events are buffered and merged into the sorted array in a single batch
+	 * by the next lookup, thus a batch of `k` changes costs `O(n + k log k)` instead of `O(n)` per change.
+	 * Equality lookups and range scans are `O(log n + m)` and do not depend on (nor change) the physical order of the
+	 * component set, thus secondary indexes can be used alongside owning collections and sorting.
+	 *
+	 * @tparam C Component type to index.
+	 * @tparam K Key extractor type. Must be invocable with `const C &` and return a totally-ordered key.
+	 *
+	 * @note Modification of components is only tracked when done through type-specific functions of the
+	 * world or component set (ex. `replace`, `apply`).
+	 * @note Since lookups merge pending changes, they must not be performed concurrently with each other
+	 * unless the index was committed (see `commit`) after the last change.
+	 * @note The index must not outlive it's world. */
+	template<typename C, typename K>
+	class sorted_index
+	{
+	public:
+		typedef std::remove_cvref_t<std::invoke_result_t<K, const C &>> key_type;
+		typedef std::pair<key_type, entity_t> value_type;
+		typedef std::size_t size_type;
+
+		static_assert(std::totally_ordered<key_type>, "Index key must be totally ordered");
+		static_assert(!detail::transient_component<C>, "Sorted indices can not index transient component types");
+
+	private:
+		struct key_cmp
+		{
+			[[nodiscard]] constexpr bool operator()(const value_type &a, const key_type &b) const noexcept
+			{
+				return a.first < b;
+			}
+			[[nodiscard]] constexpr bool operator()(const key_type &a, const value_type &b) const noexcept
+			{
+				return a < b.first;
+			}
+		};
+
+		/* Current key of an indexed entity & whether it's entry is in the sorted array. */
+		struct entry_state
+		{
+			key_type key;
+			bool committed;
+		};
+
+	public:
+		sorted_index(const sorted_index &) = delete;
+		sorted_index &operator=(const sorted_index &) = delete;
+		sorted_index(sorted_index &&) = delete;
+		sorted_index &operator=(sorted_index &&) = delete;
+
+		/** Creates a sorted index for components of type `C` of the specified world.
+		 * @param world World containing the indexed components.
+		 * @param key Key extractor instance. */
+		explicit sorted_index(entity_world &world, K key = K{}) : m_set(&world.template reserve<C>()), m_key(std::move(key))
+		{
+			/* Build the initial index in one go, then sort it. */
+			for (auto item = m_set->begin(), last = m_set->end(); item != last; ++item)
+				if (!item->first.is_tombstone()) [[likely]]
+				{
+					auto &value = m_data.emplace_back(extract(item->first), item->first);
+					m_keys.emplace(value.second, entry_state{value.first, true});
+				}
+			std::sort(m_data.begin(), m_data.end());
+
+			m_set->on_create() += delegate{delegate_func_t<&sorted_index::handle_create>{}, this};
+			m_set->on_modify() += delegate{delegate_func_t<&sorted_index::handle_modify>{}, this};
+			m_set->on_remove() += delegate{delegate_func_t<&sorted_index::handle_remove>{}, this};
+			world.on_remap() += delegate{delegate_func_t<&sorted_index::handle_remap>{}, this};
+		}
+		~sorted_index()
+		{
+			m_set->on_create() -= delegate{delegate_func_t<&sorted_index::handle_create>{}, this};
+			m_set->on_modify() -= delegate{delegate_func_t<&sorted_index::handle_modify>{}, this};
+			m_set->on_remove() -= delegate{delegate_func_t<&sorted_index::handle_remove>{}, this};
+			m_set->world().on_remap() -= delegate{delegate_func_t<&sorted_index::handle_remap>{}, this};
+		}
+
+		/** Returns the amount of indexed entities. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_keys.size(); }
+		/** Returns span of all `(key, entity)` pairs of the index in ascending key order. */
+		[[nodiscard]] constexpr std::span<const value_type> data() const
+		{
+			commit();
+			return {m_data};
+		}
+
+		/** Returns span of `(key, entity)` pairs with a key equal to `key`. */
+		[[nodiscard]] constexpr std::span<const value_type> equal_range(const key_type &key) const
+		{
+			commit();
+			const auto [first, last] = std::equal_range(m_data.begin(), m_data.end(), key, key_cmp{});
+			return {first, last};
+		}
+		/** Returns span of `(key, entity)` pairs with a key within the `[min, max]` range. */
+		[[nodiscard]] constexpr std::span<const value_type> range(const key_type &min, const key_type &max) const
+		{
+			commit();
+			const auto first = std::lower_bound(m_data.begin(), m_data.end(), min, key_cmp{});
+			const auto last = std::upper_bound(first, m_data.end(), max, key_cmp{});
+			return {first, last};
+		}
+		/** Returns the first entity with the specified key or a tombstone if none exists. */
+		[[nodiscard]] constexpr entity_t find(const key_type &key) const
+		{
+			const auto result = equal_range(key);
+			return result.empty() ? entity_t::tombstone() : result.front().second;
+		}
+
+		/** Invokes the functor for every entity with a key within the `[min, max]` range that belongs to the
+		 * specified view or collection. Entities are visited in ascending key order. */
+		template<typename V, std::invocable<entity_t> F>
+		constexpr void where(const key_type &min, const key_type &max, const V &filter, F &&f) const
+		{
+			for (auto &item : range(min, max))
+				if (filter.contains(item.second)) std::invoke(f, item.second);
+		}
+
+		/** Merges pending changes into the sorted array of the index. Invoked automatically by lookups. */
+		constexpr void commit() const
+		{
+			if (m_inserted.empty() && m_erased.empty()) [[likely]]
+				return;
+
+			/* Remove erased entries in a single pass, both arrays are ordered by `(key, entity)`. */
+			if (!m_erased.empty())
+			{
+				std::sort(m_erased.begin(), m_erased.end());
+				auto out = m_data.begin();
+				auto erased = m_erased.cbegin();
+				for (auto item = m_data.begin(); item != m_data.end(); ++item)
+				{
+					while (erased != m_erased.cend() && *erased < *item) ++erased;
+					if (erased != m_erased.cend() && *erased == *item)
+						++erased;
+					else
+					{
+						if (out != item) *out = std::move(*item);
+						++out;
+					}
+				}
+				m_data.erase(out, m_data.end());
+				m_erased.clear();
+			}
+
+			/* Sort inserted entries & drop the ones that are no longer current, then merge them. */
+			std::sort(m_inserted.begin(), m_inserted.end());
+			m_inserted.erase(std::unique(m_inserted.begin(), m_inserted.end()), m_inserted.end());
+
+			const auto mid = static_cast<std::ptrdiff_t>(m_data.size());
+			for (auto &item : m_inserted)
+				if (const auto iter = m_keys.find(item.second);
+					iter != m_keys.end() && !iter->second.committed && iter->second.key == item.first)
+				{
+					iter->second.committed = true;
+					m_data.push_back(std::move(item));
+				}
+			std::inplace_merge(m_data.begin(), m_data.begin() + mid, m_data.end());
+			m_inserted.clear();
+		}
+
+	private:
+		[[nodiscard]] constexpr key_type extract(entity_t e) const
+		{
+			return key_type{std::invoke(m_key, std::as_const(m_set->get(e)))};
+		}
+
+		constexpr void insert(entity_t e, key_type key)
+		{
+			m_inserted.emplace_back(key, e);
+			m_keys.insert_or_assign(e, entry_state{std::move(key), false});
+		}
+		constexpr void erase(entity_t e)
+		{
+			/* Entries that are not in the sorted array yet are filtered out by the next commit. */
+			if (const auto iter = m_keys.find(e); iter != m_keys.end()) [[likely]]
+			{
+				if (iter->second.committed) m_erased.emplace_back(iter->second.key, e);
+				m_keys.erase(iter);
+			}
+		}
+
+		void handle_create(entity_world &, entity_t e) { insert(e, extract(e)); }
+		void handle_modify(entity_world &, entity_t e)
+		{
+			auto key = extract(e);
+			if (const auto iter = m_keys.find(e); iter != m_keys.end())
+			{
+				/* Nothing to do if the key has not changed. */
+				if (iter->second.key == key) return;
+				if (iter->second.committed) m_erased.emplace_back(iter->second.key, e);
+			}
+			insert(e, std::move(key));
+		}
+		void handle_remove(entity_world &, entity_t e) { erase(e); }
+		void handle_remap(entity_world &, const entity_remap &table)
+		{
+			/* Merge pending changes first, so that only the sorted array needs to be remapped. Entries with equal
+			 * keys are ordered by entity, thus the array is re-sorted afterwards. Entries of entities that are no
+			 * longer alive are dropped. */
+			commit();
+			m_keys.clear();
+			std::erase_if(m_data, [&](const value_type &item) { return !table.contains(item.second); });
+			for (auto &item : m_data)
+			{
+				item.second = table[item.second];
+				m_keys.emplace(item.second, entry_state{item.first, true});
+			}
+			std::sort(m_data.begin(), m_data.end());
+		}
+
+		component_set<C> *m_set;
+		K m_key;
+
+		mutable std::vector<value_type> m_data;		/* Sorted array of committed entries. */
+		mutable std::vector<value_type> m_inserted; /* Entries pending insertion (unordered). */
+		mutable std::vector<value_type> m_erased;	/* Committed entries pending removal (unordered). */
+		mutable dense_map<entity_t, entry_state> m_keys; /* Current key of every indexed entity. */
+	};
+}	 // namespace sek
@@ -0,0 +1,285 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "world.hpp"
+
+namespace sek
+{
+	/** @brief Axis-aligned bounds used for spatial queries.
+	 * @tparam N Number of dimensions. */
+	template<std::size_t N>
+	struct spatial_bounds
+	{
+		/** Returns bounds of a sphere (circle) with the specified center & radius. */
+		[[nodiscard]] constexpr static spatial_bounds sphere(const std::array<float, N> &center, float radius) noexcept
+		{
+			spatial_bounds result;
+			for (std::size_t i = 0; i < N; ++i)
+			{
+				result.min[i] = center[i] - radius;
+				result.max[i] = center[i] + radius;
+			}
+			return result;
+		}
+
+		/** Checks if the point is within the bounds. */
+		[[nodiscard]] constexpr bool contains(const std::array<float, N> &p) const noexcept
+		{
+			for (std::size_t i = 0; i < N; ++i)
+				if (p[i] < min[i] || p[i] > max[i]) return false;
+			return true;
+		}
+
+		std::array<float, N> min = {};
+		std::array<float, N> max = {};
+	};
+
+	/** @brief Uniform hash grid used to index components of a world by position.
+	 *
+	 * Entities are bucketed into grid cells of `cell_size` using the position returned by the key extractor.
+	 * The index is updated incrementally from creation, modification and removal events of the component set,
+	 * thus region queries only touch entities of the cells overlapping the queried bounds.
+	 *
+	 * @tparam T Component type to index.
+	 * @tparam K Key extractor type. Must be invocable with `const T &` and return a position `p`, such that `p[i]`
+	 * is convertible to `float` for every `i` in `[0, N)`.
+	 * @tparam N Number of dimensions (at most 3).
+	 *
+	 * @note Modification of components is only tracked when done through type-specific functions of the
+	 * world or component set (ex. `replace`, `apply`).
+	 * @note The index must not outlive it's world. */
+	template<typename T, typename K, std::size_t N = 3>
+	class spatial_index
+	{
+		static_assert(N != 0 && N <= 3, "Spatial index supports 1 to 3 dimensions");
+		static_assert(!detail::transient_component<T>, "Spatial indices can not index transient component types");
+
+		using key_t = std::uint64_t;
+		using coord_t = std::array<std::int64_t, N>;
+
+		/* Cell of an indexed entity & it's position within the cell. */
+		struct cell_slot
+		{
+			key_t key;
+			std::size_t pos;
+		};
+
+		constexpr static key_t coord_bits = 64 / N;
+		constexpr static key_t coord_mask = (key_t{1} << coord_bits) - 1;
+
+	public:
+		typedef std::size_t size_type;
+		typedef spatial_bounds<N> bounds_type;
+		typedef std::array<float, N> point_type;
+
+	public:
+		spatial_index(const spatial_index &) = delete;
+		spatial_index &operator=(const spatial_index &) = delete;
+		spatial_index(spatial_index &&) = delete;
+		spatial_index &operator=(spatial_index &&) = delete;
+
+		/** Creates a spatial index for components of type `T` of the specified world.
+		 * @param world World containing the indexed components.
+		 * @param cell_size Size of the grid cells.
+		 * @param key Key extractor instance. */
+		spatial_index(entity_world &world, float cell_size, K key = K{})
+			: m_set(&world.template reserve<T>()), m_key(std::move(key)), m_inv_cell(1.0f / cell_size)
+		{
+			SEK_ASSERT(cell_size > 0.0f, "Cell size must be positive");
+
+			for (auto item = m_set->begin(), last = m_set->end(); item != last; ++item)
+				if (!item->first.is_tombstone()) [[likely]]
+					insert(item->first);
+
+			m_set->on_create() += delegate{delegate_func_t<&spatial_index::handle_create>{}, this};
+			m_set->on_modify() += delegate{delegate_func_t<&spatial_index::handle_modify>{}, this};
+			m_set->on_remove() += delegate{delegate_func_t<&spatial_index::handle_remove>{}, this};
+			world.on_remap() += delegate{delegate_func_t<&spatial_index::handle_remap>{}, this};
+		}
+		~spatial_index()
+		{
+			m_set->on_create() -= delegate{delegate_func_t<&spatial_index::handle_create>{}, this};
+			m_set->on_modify() -= delegate{delegate_func_t<&spatial_index::handle_modify>{}, this};
+			m_set->on_remove() -= delegate{delegate_func_t<&spatial_index::handle_remove>{}, this};
+			m_set->world().on_remap() -= delegate{delegate_func_t<&spatial_index::handle_remap>{}, this};
+		}
+
+		/** Returns the amount of indexed entities. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_entities.size(); }
+
+		/** Invokes the functor for every indexed entity, position of which is within the specified bounds. */
+		template<std::invocable<entity_t> F>
+		constexpr void for_each_within(const bounds_type &bounds, F &&f) const
+		{
+			for_each_cell(bounds,
+						  [&](const std::vector<entity_t> &cell)
+						  {
+							  for (auto e : cell)
+								  if (bounds.contains(position(e))) std::invoke(f, e);
+						  });
+		}
+		/** Invokes the functor for every indexed entity that is within the specified bounds and belongs to the
+		 * specified view or collection. */
+		template<typename V, std::invocable<entity_t> F>
+		constexpr void for_each_within(const bounds_type &bounds, const V &filter, F &&f) const
+		{
+			for_each_within(bounds,
+							[&](entity_t e)
+							{
+								if (filter.contains(e)) std::invoke(f, e);
+							});
+		}
+		/** Invokes the functor for every indexed entity within `radius` of the specified point. */
+		template<std::invocable<entity_t> F>
+		constexpr void for_each_within(const point_type &center, float radius, F &&f) const
+		{
+			const auto radius_sq = radius * radius;
+			for_each_within(bounds_type::sphere(center, radius),
+							[&](entity_t e)
+							{
+								const auto p = position(e);
+								float dist_sq = 0.0f;
+								for (std::size_t i = 0; i < N; ++i) dist_sq += (p[i] - center[i]) * (p[i] - center[i]);
+								if (dist_sq <= radius_sq) std::invoke(f, e);
+							});
+		}
+
+	private:
+		[[nodiscard]] constexpr point_type position(entity_t e) const
+		{
+			const auto p = std::invoke(m_key, std::as_const(m_set->get(e)));
+
+			point_type result;
+			for (std::size_t i = 0; i < N; ++i) result[i] = static_cast<float>(p[i]);
+			return result;
+		}
+		[[nodiscard]] constexpr coord_t cell_coords(const point_type &p) const noexcept
+		{
+			coord_t result;
+			for (std::size_t i = 0; i < N; ++i) result[i] = static_cast<std::int64_t>(std::floor(p[i] * m_inv_cell));
+			return result;
+		}
+		[[nodiscard]] constexpr static key_t cell_key(const coord_t &c) noexcept
+		{
+			/* Coordinates wrap around, cells that alias each other are filtered by the bounds check. */
+			key_t result = 0;
+			for (std::size_t i = 0; i < N; ++i) result |= (static_cast<key_t>(c[i]) & coord_mask) << (coord_bits * i);
+			return result;
+		}
+
+		template<typename F>
+		constexpr void for_each_cell(const bounds_type &bounds, F &&f) const
+		{
+			const auto first = cell_coords(bounds.min);
+			const auto last = cell_coords(bounds.max);
+
+			/* If the bounds span more cells than there are non-empty cells, go through non-empty cells instead. */
+			std::uint64_t span = 1;
+			for (std::size_t i = 0; i < N && span <= m_cells.size(); ++i)
+				span *= static_cast<std::uint64_t>(last[i] - first[i]) + 1;
+			if (span > m_cells.size())
+			{
+				for (auto &cell : m_cells) f(cell.second);
+				return;
+			}
+
+			/* Iterate all cells in the [first, last] range. */
+			for (auto c = first;;)
+			{
+				if (const auto cell = m_cells.find(cell_key(c)); cell != m_cells.end()) f(cell->second);
+
+				std::size_t i = 0;
+				for (; i < N && c[i] == last[i]; ++i) c[i] = first[i];
+				if (i == N) break;
+				++c[i];
+			}
+		}
+
+		constexpr void insert(entity_t e)
+		{
+			const auto key = cell_key(cell_coords(position(e)));
+			m_entities.emplace(e, cell_slot{key, insert_into_cell(key, e)});
+		}
+		constexpr void erase(entity_t e)
+		{
+			const auto iter = m_entities.find(e);
+			if (iter == m_entities.end()) [[unlikely]]
+				return;
+
+			erase_from_cell(iter->second);
+			m_entities.erase(iter);
+		}
+		[[nodiscard]] constexpr size_type insert_into_cell(key_t key, entity_t e)
+		{
+			auto &cell = m_cells[key];
+			cell.push_back(e);
+			return cell.size() - 1;
+		}
+		constexpr void erase_from_cell(const cell_slot &slot)
+		{
+			/* Swap & pop the entity, updating slot of the moved one. */
+			const auto cell = m_cells.find(slot.key);
+			auto &entities = cell->second;
+			if (const auto last = entities.back(); slot.pos != entities.size() - 1)
+			{
+				entities[slot.pos] = last;
+				m_entities.find(last)->second.pos = slot.pos;
+			}
+			entities.pop_back();
+
+			/* Remove empty cells, so that sparse worlds do not accumulate cells. */
+			if (entities.empty()) m_cells.erase(cell);
+		}
+
+		void handle_create(entity_world &, entity_t e) { insert(e); }
+		void handle_modify(entity_world &, entity_t e)
+		{
+			const auto iter = m_entities.find(e);
+			if (iter == m_entities.end()) [[unlikely]]
+				return insert(e);
+
+			/* Only move the entity if it has changed cells. */
+			if (const auto key = cell_key(cell_coords(position(e))); key != iter->second.key)
+			{
+				erase_from_cell(iter->second);
+				iter->second = cell_slot{key, insert_into_cell(key, e)};
+			}
+		}
+		void handle_remove(entity_world &, entity_t e) { erase(e); }
+		void handle_remap(entity_world &, const entity_remap &table)
+		{
+			/* Entities that are no longer alive are erased first. Cells & positions of the rest are kept, only
+			 * entities are replaced. */
+			std::vector<entity_t> dead;
+			for (auto &item : m_entities)
+				if (!table.contains(item.first)) dead.push_back(item.first);
+			for (auto e : dead) erase(e);
+
+			dense_map<entity_t, cell_slot> entities;
+			for (auto &cell : m_cells)
+				for (size_type i = 0; i < cell.second.size(); ++i)
+				{
+					auto &e = cell.second[i];
+					e = table[e];
+					entities.emplace(e, cell_slot{cell.first, i});
+				}
+			m_entities = std::move(entities);
+		}
+
+		component_set<T> *m_set;
+		K m_key;
+		float m_inv_cell;
+
+		dense_map<key_t, std::vector<entity_t>> m_cells;
+		dense_map<entity_t, cell_slot> m_entities; /* Cell slot of every indexed entity. */
+	};
+}	 // namespace sek
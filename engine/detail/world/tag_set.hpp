@@ -0,0 +1,187 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "entity.hpp"
+#include "traits.hpp"
+
+namespace sek
+{
+	namespace detail
+	{
+		template<typename T>
+		concept bitset_component = std::is_empty_v<T> && requires { requires component_traits<T>::is_bitset; };
+
+		[[nodiscard]] inline std::span<const entity_t> world_entities(const entity_world &world) noexcept;
+	}	 // namespace detail
+
+	/** @brief Type-erased storage of a tag component type, represented as a bit array indexed by entity index.
+	 *
+	 * Tag sets are used instead of component sets for empty component types with the `is_bitset` trait
+	 * (see `component_traits`). Adding & removing tags is a single bit operation, there is no dense array of
+	 * entities, and iteration processes a word of bits at a time.
+	 *
+	 * Since bits are indexed by entity index only, tag sets do not track entity versions. Entities passed to tag
+	 * sets must be alive, and the parent world clears bits of entities when they are released.
+	 *
+	 * @note Tag sets do not dispatch component events, do not support lock & enable flags and can not be used by
+	 * collections, observers or other helpers that require a component set. */
+	class generic_tag_set
+	{
+		friend class entity_world;
+
+	public:
+		typedef std::size_t size_type;
+
+	private:
+		constexpr static size_type word_bits = std::numeric_limits<size_type>::digits;
+
+		[[nodiscard]] constexpr static size_type word_idx(size_type i) noexcept { return i / word_bits; }
+		[[nodiscard]] constexpr static size_type bit_mask(size_type i) noexcept
+		{
+			return size_type{1} << (i % word_bits);
+		}
+
+	public:
+		generic_tag_set(const generic_tag_set &) = delete;
+		generic_tag_set &operator=(const generic_tag_set &) = delete;
+
+		explicit generic_tag_set(entity_world &world) noexcept : m_world(&world) {}
+		virtual ~generic_tag_set() = default;
+
+		/** Returns reference to the parent world of the set. */
+		[[nodiscard]] constexpr entity_world &world() const noexcept { return *m_world; }
+
+		/** Returns the amount of entities with the tag. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_size; }
+		/** Checks if no entities have the tag. */
+		[[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+
+		/** Checks if the entity has the tag. This is a single bit test.
+		 * @note Entity version is not checked, the entity must be alive. */
+		[[nodiscard]] constexpr bool contains(entity_t entity) const noexcept
+		{
+			const auto i = entity.index().value();
+			const auto idx = word_idx(i);
+			return idx < m_words.size() && (m_words[idx] & bit_mask(i));
+		}
+
+		/** Adds the tag to the entity.
+		 * @return `true` if the tag was added, `false` if the entity already had it. */
+		constexpr bool insert(entity_t entity)
+		{
+			const auto i = entity.index().value();
+			if (const auto idx = word_idx(i); idx >= m_words.size())
+				m_words.resize(std::max(idx + 1, m_words.size() * 2), 0);
+
+			auto &word = m_words[word_idx(i)];
+			if (word & bit_mask(i)) return false;
+			word |= bit_mask(i);
+			return ++m_size, true;
+		}
+		/** Removes the tag from the entity.
+		 * @return `true` if the tag was removed, `false` if the entity did not have it. */
+		constexpr bool erase(entity_t entity) noexcept
+		{
+			if (!contains(entity)) return false;
+
+			const auto i = entity.index().value();
+			m_words[word_idx(i)] &= ~bit_mask(i);
+			return --m_size, true;
+		}
+		/** Removes the tag from all entities. */
+		constexpr void clear() noexcept
+		{
+			std::fill(m_words.begin(), m_words.end(), 0);
+			m_size = 0;
+		}
+
+		/** Invokes the functor for every entity with the tag, in order of entity indices.
+		 * Bits are scanned a word at a time, thus empty ranges of the set are skipped in bulk.
+		 * Functor may optionally return a value, which if evaluated to `false`, prematurely terminates iteration. */
+		template<std::invocable<entity_t> F>
+		constexpr void for_each(F &&f) const
+		{
+			const auto entities = detail::world_entities(*m_world);
+			for (size_type idx = 0; idx < m_words.size(); ++idx)
+				for (auto word = m_words[idx]; word != 0; word &= word - 1)
+				{
+					const auto e = entities[idx * word_bits + static_cast<size_type>(std::countr_zero(word))];
+					if constexpr (std::convertible_to<std::invoke_result_t<F, entity_t>, bool>)
+					{
+						if (!std::invoke(f, e)) [[unlikely]]
+							return;
+					}
+					else
+						std::invoke(f, e);
+				}
+		}
+
+	private:
+		constexpr void rebind(entity_world &world) noexcept { m_world = &world; }
+
+		/* Moves bits to new indices of their entities. Bits are only set for alive entities, thus no version checks
+		 * are needed. See `entity_world::defragment`. */
+		void remap(const entity_remap &remap)
+		{
+			const auto &table = remap.new_entities();
+			std::vector<size_type> words(m_words.size(), 0);
+			for (size_type idx = 0; idx < m_words.size(); ++idx)
+				for (auto word = m_words[idx]; word != 0; word &= word - 1)
+				{
+					const auto i = idx * word_bits + static_cast<size_type>(std::countr_zero(word));
+					if (const auto e = table[i]; !e.is_tombstone()) [[likely]]
+					{
+						const auto to = e.index().value();
+						words[word_idx(to)] |= bit_mask(to);
+					}
+					else
+						--m_size;
+				}
+			m_words.swap(words);
+		}
+
+		std::vector<size_type> m_words;
+		size_type m_size = 0;
+		entity_world *m_world;
+	};
+
+	/** @brief Bitset storage of the tag component type `T`. See `generic_tag_set`. */
+	template<typename T>
+	class tag_set final : public generic_tag_set, ebo_base_helper<T>
+	{
+		static_assert(detail::bitset_component<T>, "Tag sets are only available for bitset tag types");
+
+		using value_base = ebo_base_helper<T>;
+
+	public:
+		typedef T value_type;
+
+	public:
+		using generic_tag_set::generic_tag_set;
+
+		/** Returns reference to the tag of the entity. All entities share the same instance of the tag. */
+		[[nodiscard]] constexpr T &get(entity_t) noexcept { return *value_base::get(); }
+		/** @copydoc get */
+		[[nodiscard]] constexpr const T &get(entity_t) const noexcept { return *value_base::get(); }
+
+		/** Adds the tag to the entity.
+		 * @return Reference to the tag. */
+		constexpr T &emplace(entity_t entity)
+		{
+			insert(entity);
+			return get(entity);
+		}
+	};
+}	 // namespace sek
@@ -0,0 +1,129 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace sek::detail
+{
+	/* Dense index of the calling thread. Indices of exited threads are re-used, thus indices are bounded by the
+	 * maximum amount of concurrently running threads. */
+	class thread_index
+	{
+		struct registry
+		{
+			std::mutex mtx;
+			std::vector<std::size_t> free;
+			std::size_t next = 0;
+		};
+
+		[[nodiscard]] static registry &get_registry() noexcept
+		{
+			static registry value;
+			return value;
+		}
+
+		thread_index()
+		{
+			auto &r = get_registry();
+			const std::lock_guard<std::mutex> l(r.mtx);
+			if (r.free.empty())
+				m_value = r.next++;
+			else
+			{
+				m_value = r.free.back();
+				r.free.pop_back();
+			}
+		}
+		~thread_index()
+		{
+			auto &r = get_registry();
+			const std::lock_guard<std::mutex> l(r.mtx);
+			r.free.push_back(m_value);
+		}
+
+	public:
+		[[nodiscard]] static std::size_t get()
+		{
+			thread_local thread_index instance;
+			return instance.m_value;
+		}
+
+	private:
+		std::size_t m_value;
+	};
+
+	/* Per-thread instances of `T`, created on first use by every thread. Instances are found in `O(1)` via a table
+	 * of slots indexed by the dense thread index, thus threads do not need to keep track of the containers they have
+	 * used. Slots are only written by the thread they belong to (under a lock, once per thread), and instances of
+	 * exited threads are inherited by threads re-using their index. */
+	template<typename T>
+	class thread_slots
+	{
+		constexpr static std::size_t page_size = 64;
+		constexpr static std::size_t page_count = 64;
+
+		struct slot_page
+		{
+			std::array<std::atomic<T *>, page_size> slots = {};
+		};
+
+	public:
+		/* Maximum amount of concurrently running threads that can use the slots. */
+		constexpr static std::size_t max_threads = page_size * page_count;
+
+	public:
+		thread_slots(const thread_slots &) = delete;
+		thread_slots &operator=(const thread_slots &) = delete;
+
+		thread_slots() noexcept = default;
+
+		/* Returns the instance of the calling thread, creating it if needed.
+		 * Throws `std::length_error` if the calling thread can not be assigned a slot. */
+		[[nodiscard]] T &local()
+		{
+			const auto idx = thread_index::get();
+			if (idx >= max_threads) [[unlikely]]
+				throw std::length_error("Thread index exceeds the maximum amount of per-thread slots");
+
+			auto &page = m_pages[idx / page_size];
+			if (const auto p = page.load(std::memory_order_acquire); p != nullptr) [[likely]]
+				if (const auto v = p->slots[idx % page_size].load(std::memory_order_relaxed); v != nullptr) [[likely]]
+					return *v;
+
+			const std::lock_guard<std::mutex> l(m_mtx);
+			auto *p = page.load(std::memory_order_relaxed);
+			if (p == nullptr)
+			{
+				p = m_pages_data.emplace_back(std::make_unique<slot_page>()).get();
+				page.store(p, std::memory_order_release);
+			}
+
+			auto *result = m_values.emplace_back(std::make_unique<T>()).get();
+			p->slots[idx % page_size].store(result, std::memory_order_relaxed);
+			return *result;
+		}
+
+		/* Invokes the functor for instances of all threads under a lock. */
+		template<typename F>
+		void for_each(F &&f)
+		{
+			const std::lock_guard<std::mutex> l(m_mtx);
+			for (auto &value : m_values) f(*value);
+		}
+
+	private:
+		std::mutex m_mtx;
+		std::vector<std::unique_ptr<T>> m_values;
+		std::vector<std::unique_ptr<slot_page>> m_pages_data;
+		std::array<std::atomic<slot_page *>, page_count> m_pages = {};
+	};
+}	 // namespace sek::detail
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include "fwd.hpp"
+#include "page_arena.hpp"
 
 namespace sek
 {
@@ -12,14 +15,51 @@ namespace sek
 	 *
 	 * Component traits must contain a compile-time constant of type `std::size_t` named `page_size`, specifying
 	 * size of allocation pages used by component pools, a `allocator_type` typedef used to specify the allocator of
-	 * used to allocate components. */
+	 * used to allocate components.
+	 *
+	 * By default, components are allocated using `std::allocator`. If `SEK_WORLD_PAGE_ARENA` is defined, component pages
+	 * are instead allocated from the page arena of the parent world via `page_allocator`.
+	 *
+	 * Component traits may optionally contain a compile-time constant of type `bool` named `is_contiguous`, specifying
+	 * whether components should be stored in a single contiguous buffer instead of pages. Contiguous storage is only
+	 * available for trivially copyable non-empty types and does not guarantee pointer stability for unlocked components.
+	 * Locking a contiguous component relocates it to a separately allocated node. Contiguous storage is disabled
+	 * by default and must be enabled by specializing `component_traits`.
+	 *
+	 * Component traits may optionally contain a compile-time constant of type `bool` named `is_transient`, specifying
+	 * that components only live for a single frame. Storage of transient components is allocated from the frame arena
+	 * of their world and is released all at once by `entity_world::end_frame`, without destroying components or
+	 * dispatching removal events. Transient components must be trivially destructible, and can not be used by
+	 * hierarchies, indices, observers, relations or snapshots.
+	 *
+	 * Component traits of empty (tag) types may optionally contain a compile-time constant of type `bool` named
+	 * `is_bitset`, specifying that the tag is stored by the world as a bit array indexed by entity index (see `tag_set`)
+	 * instead of a component set. Bitset tags are added & removed in `O(1)` without a dense array of entities, and can
+	 * be included, excluded or optional in views, but do not dispatch component events, do not have lock or enable
+	 * flags, and can not be used by collections, observers or other helpers that require a component set.
+	 *
+	 * Component traits may optionally contain a static function named `unique_key`, returning a unique key of a component
+	 * (ex. a network ID or an asset GUID). Component sets of such types maintain a hash index of keys, used to find
+	 * entities by key in `O(1)` via `component_set::find_by` and `entity_world::find_by`. The index is updated when
+	 * components are created, removed or modified via type-specific functions of the world or component set.
+	 * Creating a component with a key that is already in use throws `std::invalid_argument` and leaves the set
+	 * unchanged. Modifying a component to use such a key throws `std::invalid_argument` before modification events
+	 * are dispatched. Replaced components are left unchanged & indexed under their old key. Components modified via
+	 * `apply` are restored to their old value & stay indexed if they are copy-constructible, and are otherwise left
+	 * out of the index. */
 	template<typename T>
 	struct component_traits
 	{
 		/** Size of individual component pages of component sets. */
 		constexpr static std::size_t page_size = 1024;
 		/** Allocator type used for component pages. */
+#ifdef SEK_WORLD_PAGE_ARENA
+		typedef page_allocator<T> allocator_type;
+#else
 		typedef std::allocator<T> allocator_type;
+#endif
+		/** Components are stored in pages by default. */
+		constexpr static bool is_contiguous = false;
 	};
 
 }	 // namespace sek
\ No newline at end of file
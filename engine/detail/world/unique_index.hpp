@@ -0,0 +1,266 @@
+/*
+ * Created by switchblade on 19/07/22
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "entity.hpp"
+#include "traits.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace sek::detail
+{
+	// clang-format off
+	template<typename T>
+	concept keyed_component = requires(const T &value)
+	{
+		component_traits<T>::unique_key(value);
+		requires std::equality_comparable<std::remove_cvref_t<decltype(component_traits<T>::unique_key(value))>>;
+	};
+	// clang-format on
+
+	template<typename T>
+	using unique_key_t = std::remove_cvref_t<decltype(component_traits<T>::unique_key(std::declval<const T &>()))>;
+
+	/** @brief Open-addressing hash table mapping unique component keys to entities.
+	 *
+	 * Slots are grouped into groups of `group_size` control bytes, each of which either marks the slot as empty,
+	 * deleted or stores the 7 low bits of the key's hash. Lookups probe whole groups at once (using SSE2 when
+	 * available), thus only slots with a matching hash fragment are compared against the key.
+	 *
+	 * Hashes are passed through a multiply-xorshift mixer before use, since `std::hash` of integers is usually
+	 * the identity function, which would leave sequential keys with the same high bits. */
+	template<typename K, typename H = std::hash<K>>
+	class unique_index
+	{
+		using ctrl_t = std::int8_t;
+
+		constexpr static ctrl_t ctrl_empty = -128;
+		constexpr static ctrl_t ctrl_deleted = -2;
+
+		constexpr static std::size_t group_size = 16;
+
+		struct slot_t
+		{
+			K key;
+			entity_t entity;
+		};
+
+		/* Bit mask of slots within a group. */
+		class group_mask
+		{
+		public:
+			constexpr explicit group_mask(std::uint32_t bits) noexcept : m_bits(bits) {}
+
+			[[nodiscard]] constexpr bool empty() const noexcept { return m_bits == 0; }
+			[[nodiscard]] constexpr std::size_t next() noexcept
+			{
+				const auto result = static_cast<std::size_t>(std::countr_zero(m_bits));
+				m_bits &= m_bits - 1;
+				return result;
+			}
+
+		private:
+			std::uint32_t m_bits;
+		};
+
+		[[nodiscard]] static group_mask match(const ctrl_t *group, ctrl_t value) noexcept
+		{
+#ifdef __SSE2__
+			const auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+			return group_mask{static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))))};
+#else
+			std::uint32_t bits = 0;
+			for (std::size_t i = 0; i < group_size; ++i) bits |= std::uint32_t{group[i] == value} << i;
+			return group_mask{bits};
+#endif
+		}
+
+		[[nodiscard]] constexpr static std::size_t mix(std::size_t h) noexcept
+		{
+			if constexpr (sizeof(std::size_t) >= sizeof(std::uint64_t))
+			{
+				h = (h ^ (h >> 33)) * 0xff51afd7ed558ccd;
+				h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53;
+				return h ^ (h >> 33);
+			}
+			else
+			{
+				h = (h ^ (h >> 16)) * 0x85ebca6b;
+				h = (h ^ (h >> 13)) * 0xc2b2ae35;
+				return h ^ (h >> 16);
+			}
+		}
+		[[nodiscard]] constexpr static ctrl_t h2(std::size_t h) noexcept { return static_cast<ctrl_t>(h & 0x7f); }
+		[[nodiscard]] constexpr static std::size_t h1(std::size_t h) noexcept { return h >> 7; }
+
+	public:
+		typedef K key_type;
+		typedef std::size_t size_type;
+
+	public:
+		unique_index(const unique_index &) = delete;
+		unique_index &operator=(const unique_index &) = delete;
+
+		constexpr unique_index() noexcept = default;
+		unique_index(unique_index &&other) noexcept { swap(other); }
+		unique_index &operator=(unique_index &&other) noexcept
+		{
+			swap(other);
+			return *this;
+		}
+		~unique_index()
+		{
+			clear();
+			if (m_slots != nullptr) std::allocator<slot_t>{}.deallocate(m_slots, capacity());
+		}
+
+		/** Returns the amount of keys in the index. */
+		[[nodiscard]] constexpr size_type size() const noexcept { return m_size; }
+
+		/** Returns the entity associated with the key or a tombstone if the key is not indexed. */
+		[[nodiscard]] entity_t find(const K &key) const noexcept
+		{
+			if (m_size == 0) return entity_t::tombstone();
+
+			const auto h = mix(m_hash(key));
+			for (auto g = h1(h) & m_group_mask, step = std::size_t{0};; g = (g + ++step) & m_group_mask)
+			{
+				const auto group = m_ctrl.get() + g * group_size;
+				for (auto m = match(group, h2(h)); !m.empty();)
+					if (const auto &slot = m_slots[g * group_size + m.next()]; slot.key == key) return slot.entity;
+				if (!match(group, ctrl_empty).empty()) return entity_t::tombstone();
+			}
+		}
+
+		/** Associates the key with the entity.
+		 * @return `true` if the key was inserted, `false` if the key is already associated with another entity. */
+		bool insert(const K &key, entity_t e)
+		{
+			if ((m_size + m_deleted + 1) * 8 > capacity() * 7) [[unlikely]]
+				rehash((m_size + 1) * 2);
+
+			const auto h = mix(m_hash(key));
+			std::size_t target = capacity();
+			for (auto g = h1(h) & m_group_mask, step = std::size_t{0};; g = (g + ++step) & m_group_mask)
+			{
+				const auto group = m_ctrl.get() + g * group_size;
+				for (auto m = match(group, h2(h)); !m.empty();)
+					if (m_slots[g * group_size + m.next()].key == key) return false;
+
+				/* Remember the first deleted slot, so that it can be re-used once the key is known to be unique. */
+				if (auto m = match(group, ctrl_deleted); target == capacity() && !m.empty())
+					target = g * group_size + m.next();
+				if (auto m = match(group, ctrl_empty); !m.empty())
+				{
+					if (target == capacity())
+						target = g * group_size + m.next();
+					else
+						--m_deleted;
+					break;
+				}
+			}
+
+			std::construct_at(m_slots + target, slot_t{key, e});
+			m_ctrl[target] = h2(h);
+			++m_size;
+			return true;
+		}
+		/** Removes the key from the index if it is associated with the specified entity.
+		 * @return `true` if the key was removed, `false` if it was not indexed for the entity. */
+		bool erase(const K &key, entity_t e)
+		{
+			if (m_size == 0) return false;
+
+			const auto h = mix(m_hash(key));
+			for (auto g = h1(h) & m_group_mask, step = std::size_t{0};; g = (g + ++step) & m_group_mask)
+			{
+				const auto group = m_ctrl.get() + g * group_size;
+				for (auto m = match(group, h2(h)); !m.empty();)
+					if (const auto i = g * group_size + m.next(); m_slots[i].key == key)
+					{
+						if (m_slots[i].entity != e) return false;
+
+						/* Slots of groups without empty slots may be part of a probe sequence and must be marked deleted. */
+						const auto has_empty = !match(group, ctrl_empty).empty();
+						m_ctrl[i] = has_empty ? ctrl_empty : ctrl_deleted;
+						m_deleted += !has_empty;
+						std::destroy_at(m_slots + i);
+						--m_size;
+						return true;
+					}
+				if (!match(group, ctrl_empty).empty()) return false;
+			}
+		}
+
+		/** Removes all keys from the index. */
+		void clear() noexcept
+		{
+			for (std::size_t i = 0; i < capacity(); ++i)
+				if (m_ctrl[i] >= 0) std::destroy_at(m_slots + i);
+			if (m_ctrl) std::memset(m_ctrl.get(), ctrl_empty, capacity());
+			m_size = m_deleted = 0;
+		}
+
+		void swap(unique_index &other) noexcept
+		{
+			using std::swap;
+			swap(m_ctrl, other.m_ctrl);
+			swap(m_slots, other.m_slots);
+			swap(m_group_mask, other.m_group_mask);
+			swap(m_size, other.m_size);
+			swap(m_deleted, other.m_deleted);
+			swap(m_hash, other.m_hash);
+		}
+		friend void swap(unique_index &a, unique_index &b) noexcept { a.swap(b); }
+
+	private:
+		[[nodiscard]] constexpr size_type capacity() const noexcept { return m_ctrl ? (m_group_mask + 1) * group_size : 0; }
+
+		void rehash(size_type n)
+		{
+			/* Keep the load factor of the new table below 7/8. */
+			const auto groups = std::bit_ceil((n * 8 / 7 + group_size) / group_size);
+
+			auto old = unique_index{};
+			swap(old);
+			m_hash = old.m_hash;
+			m_ctrl = std::make_unique<ctrl_t[]>(groups * group_size);
+			m_slots = std::allocator<slot_t>{}.allocate(groups * group_size);
+			m_group_mask = groups - 1;
+			std::memset(m_ctrl.get(), ctrl_empty, groups * group_size);
+
+			for (std::size_t i = 0; i < old.capacity(); ++i)
+				if (old.m_ctrl[i] >= 0) insert(old.m_slots[i].key, old.m_slots[i].entity);
+		}
+
+		std::unique_ptr<ctrl_t[]> m_ctrl;
+		slot_t *m_slots = nullptr;
+		size_type m_group_mask = 0;
+		size_type m_size = 0;
+		size_type m_deleted = 0;
+		[[no_unique_address]] H m_hash;
+	};
+
+	/* Unique key index of a component set. Empty for component types without a unique key. */
+	template<typename T>
+	struct component_index
+	{
+		constexpr void clear() noexcept {}
+		constexpr void swap(component_index &) noexcept {}
+	};
+	template<keyed_component T>
+	struct component_index<T> : unique_index<unique_key_t<T>>
+	{
+	};
+}	 // namespace sek::detail
@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
 
 #include "component_set.hpp"
+#include "query_plan.hpp"
+#include "tag_set.hpp"
 
 namespace sek
 {
-	template<typename, typename = excluded_t<>, typename = optional_t<>>
+	template<typename, typename = excluded_t<>, typename = optional_t<>, typename = enabled_t<>>
 	class component_view;
 
 	/** @brief Structure used to provide a simple view of components for a set of entities.
@@ -21,18 +26,28 @@ namespace sek
 	 * retrieving a component (set -> entity -> component instead of set -> component). Unlike collections, views
 	 * do not track creation and destruction of entities.
 	 *
+	 * Bitset tag types (see `tag_set`) can be included, excluded or optional, in which case they are tested with
+	 * a single bit lookup. Tag sets are never used as the main set of a view.
+	 *
 	 * @tparam I Component types captured by the view.
 	 * @tparam E Component types excluded from the view.
-	 * @tparam P Optional components of the view. */
-	template<typename... I, typename... E, typename... P>
-	class component_view<included_t<I...>, excluded_t<E...>, optional_t<P...>>
+	 * @tparam P Optional components of the view.
+	 * @tparam Q Included components, entities of which are only accepted while the component is enabled. */
+	template<typename... I, typename... E, typename... P, typename... Q>
+	class component_view<included_t<I...>, excluded_t<E...>, optional_t<P...>, enabled_t<Q...>>
 	{
+		template<typename T>
+		constexpr static bool is_tag = detail::bitset_component<std::remove_cv_t<T>>;
+
 		static_assert(sizeof...(I) != 0, "View include at least 1 component type");
+		static_assert((is_in_v<Q, I...> && ...), "Enabled-only component types must be included");
+		static_assert(!(is_tag<I> && ...), "View must include at least 1 non-tag component type, use `tag_set::for_each` instead");
+		static_assert(!(is_tag<Q> || ...), "Bitset tag types can not be enabled-only");
 
 		using common_set = generic_component_set;
 
 		template<typename T>
-		using set_ptr_t = transfer_cv_t<T, component_set<std::remove_cv_t<T>>> *;
+		using set_ptr_t = transfer_cv_t<T, std::conditional_t<is_tag<T>, tag_set<std::remove_cv_t<T>>, component_set<std::remove_cv_t<T>>>> *;
 		using inc_ptr = std::tuple<set_ptr_t<I>...>;
 		using exc_ptr = std::tuple<set_ptr_t<E>...>;
 		using opt_ptr = std::tuple<set_ptr_t<P>...>;
@@ -52,6 +67,59 @@ namespace sek
 		{
 			return std::get<set_ptr_t<T>>(exc)->contains(e);
 		}
+		template<typename T>
+		[[nodiscard]] constexpr static bool enabled(entity_t e, const inc_ptr &inc) noexcept
+		{
+			return std::get<set_ptr_t<T>>(inc)->is_enabled(e);
+		}
+
+		/* Include tests are numbered `[0, sizeof...(I))`, followed by exclude tests. Planned views evaluate tests in
+		 * the order of a permutation selected at runtime, unplanned views use a compile-time fold. */
+		constexpr static std::size_t test_count = sizeof...(I) + sizeof...(E);
+		static_assert(test_count <= std::numeric_limits<std::uint8_t>::max(), "Too many view component types");
+
+		template<std::size_t N>
+		[[nodiscard]] constexpr bool test(entity_t e) const noexcept
+		{
+			if constexpr (N < sizeof...(I))
+			{
+				/* Entities are only tested after the main set, thus it's own test is skipped. */
+				using T = std::tuple_element_t<N, std::tuple<I...>>;
+				return main_candidate<T>(m_included) == m_set || accept<T>(e, m_included);
+			}
+			else
+				return !reject<std::tuple_element_t<N - sizeof...(I), std::tuple<E...>>>(e, m_excluded);
+		}
+		template<std::size_t... Ns>
+		[[nodiscard]] constexpr bool test_at(std::size_t i, entity_t e, std::index_sequence<Ns...>) const noexcept
+		{
+			/* Compiles to a jump table over the test index. */
+			bool result = true;
+			((i == Ns && (result = test<Ns>(e), true)) || ...);
+			return result;
+		}
+		[[nodiscard]] constexpr bool test_at(std::size_t i, entity_t e) const noexcept
+		{
+			return test_at(i, e, std::make_index_sequence<test_count>{});
+		}
+		template<std::size_t... Ns>
+		[[nodiscard]] constexpr bool test_all(entity_t e, std::index_sequence<Ns...>) const noexcept
+		{
+			return (test<Ns>(e) && ...);
+		}
+
+		/* Tests an entity of the main set against the rest of the view. */
+		[[nodiscard]] constexpr bool accepts(entity_t e) const noexcept
+		{
+			if (!m_planned) [[likely]]
+			{
+				if (!test_all(e, std::make_index_sequence<test_count>{})) return false;
+			}
+			else
+				for (auto i : m_order)
+					if (!test_at(i, e)) return false;
+			return (enabled<Q>(e, m_included) && ...);
+		}
 
 		class view_iterator
 		{
@@ -129,14 +197,28 @@ namespace sek
 		private:
 			[[nodiscard]] constexpr difference_type next_valid(difference_type i) const noexcept
 			{
-				while (i != 0 && !valid(i)) --i;
+				if (const auto flags = m_view->m_flags; flags != nullptr)
+					while (i != 0)
+					{
+						/* Skip runs of disabled components of the main set a word at a time. */
+						const auto idx = flags->prev_enabled(static_cast<size_type>(i - 1));
+						if (idx == detail::component_flags::npos) return 0;
+						if (i = static_cast<difference_type>(idx + 1); valid(i)) break;
+						--i;
+					}
+				else
+					while (i != 0 && !valid(i)) --i;
 				return i;
 			}
 			[[nodiscard]] constexpr pointer get(difference_type i) const noexcept
 			{
 				return m_view->m_set->data() + i - 1;
 			}
-			[[nodiscard]] constexpr bool valid(difference_type i) const noexcept { return m_view->contains(*get(i)); }
+			[[nodiscard]] constexpr bool valid(difference_type i) const noexcept
+			{
+				const auto e = *get(i);
+				return !e.is_tombstone() && m_view->accepts(e);
+			}
 
 			const component_view *m_view = nullptr;
 			difference_type m_off = 0;
@@ -156,15 +238,45 @@ namespace sek
 		typedef typename view_iterator::difference_type difference_type;
 
 	private:
+		/* Returns the component set of an included type, or `nullptr` for tag sets, which can not be the main set. */
 		template<typename T>
-		[[nodiscard]] constexpr static const common_set *select_common(T *storage) noexcept
+		[[nodiscard]] constexpr static const common_set *main_candidate(const inc_ptr &inc) noexcept
 		{
-			return static_cast<const common_set *>(storage);
+			if constexpr (is_tag<T>)
+				return nullptr;
+			else
+				return std::get<set_ptr_t<T>>(inc);
 		}
-		template<typename T0, typename T1, typename... Ts>
-		[[nodiscard]] constexpr static const common_set *select_common(T0 *a, T1 *b, Ts *...rest) noexcept
+		[[nodiscard]] constexpr static const common_set *select_common(const inc_ptr &inc) noexcept
 		{
-			return a->size() < b->size() ? select_common(a, rest...) : select_common(b, rest...);
+			const common_set *result = nullptr;
+			for (auto set : {main_candidate<I>(inc)...})
+				if (set != nullptr && (result == nullptr || set->size() < result->size())) result = set;
+			return result;
+		}
+		constexpr void plan() noexcept
+		{
+			const std::array<const common_set *, sizeof...(I)> sets = {main_candidate<I>(m_included)...};
+			m_set = detail::query_plan::select_main(sets, test_count);
+
+			std::array<std::pair<size_type, std::uint8_t>, test_count> stats;
+			for (std::size_t i = 0; i < test_count; ++i) stats[i] = {0, static_cast<std::uint8_t>(i)};
+			detail::query_plan::order_tests<std::uint8_t>(m_set, stats, [this](auto i, entity_t e) { return test_at(i, e); });
+			for (std::size_t i = 0; i < test_count; ++i) m_order[i] = stats[i].second;
+			m_planned = true;
+		}
+
+		[[nodiscard]] constexpr static const detail::component_flags *select_flags(const common_set *set, const inc_ptr &inc) noexcept
+		{
+			/* If the main set is an enabled-only set, its flags can be used to skip disabled entities in bulk. */
+			const detail::component_flags *result = nullptr;
+			constexpr auto select = []<typename T>(type_selector_t<T>, const common_set *set, const inc_ptr &inc, auto *&out)
+			{
+				if (const auto ptr = std::get<set_ptr_t<T>>(inc); static_cast<const common_set *>(ptr) == set)
+					out = &ptr->flags();
+			};
+			(select(type_selector<Q>, set, inc, result), ...);
+			return result;
 		}
 
 	public:
@@ -180,11 +292,16 @@ namespace sek
 		 * @param inc Pointers to component sets of included components.
 		 * @param exc Pointers to component sets of excluded components.
 		 * @param opt Pointers to component sets of optional components.
-		 * @note The smallest component set will be used as the main set. */
+		 * @note The smallest component set will be used as the main set. For large sets, the main set and the order
+		 * of include & exclude tests are selected using statistics sampled from the component sets. */
 		constexpr explicit component_view(set_ptr_t<I>... inc, set_ptr_t<E>... exc, set_ptr_t<P>... opt)
-			: m_set(select_common(inc...)), m_included(inc...), m_excluded(exc...), m_optional(opt...)
+			: m_set(nullptr), m_included(inc...), m_excluded(exc...), m_optional(opt...)
 		{
 			SEK_ASSERT(((inc != nullptr) && ...), "Included component sets can not be null");
+			m_set = select_common(m_included);
+			if constexpr (test_count > 1)
+				if (((inc->size() >= detail::query_plan::plan_threshold) || ...)) plan();
+			m_flags = select_flags(m_set, m_included);
 		}
 
 		/** Rebinds view to use the specified component set as the main set. */
@@ -192,7 +309,9 @@ namespace sek
 		constexpr component_view &rebind() noexcept
 		{
 			static_assert(is_in_v<std::remove_cv_t<C>, std::remove_cv_t<I>...>, "Can only rebind included component sets");
+			static_assert(!is_tag<C>, "Tag sets can not be used as the main set");
 			m_set = std::get<set_ptr_t<C>>(m_included);
+			m_flags = select_flags(m_set, m_included);
 			return *this;
 		}
 
@@ -226,9 +345,7 @@ namespace sek
 		/** Checks if the the view contains the specified entity. */
 		[[nodiscard]] constexpr bool contains(entity_t entity) const noexcept
 		{
-			const auto &inc = m_included;
-			const auto &exc = m_excluded;
-			return m_set != nullptr && (accept<I>(entity, inc) && ...) && !(reject<E>(entity, exc) || ...);
+			return m_set != nullptr && m_set->contains(entity) && accepts(entity);
 		}
 		/** Returns iterator to the specified entity, or an end iterator if the entity does not belong to the view. */
 		[[nodiscard]] constexpr iterator find(entity_t entity) const noexcept
@@ -286,6 +403,9 @@ namespace sek
 		{
 			using std::swap;
 			swap(m_set, other.m_set);
+			swap(m_flags, other.m_flags);
+			swap(m_order, other.m_order);
+			swap(m_planned, other.m_planned);
 			swap(m_included, other.m_included);
 			swap(m_excluded, other.m_excluded);
 			swap(m_optional, other.m_optional);
@@ -308,7 +428,10 @@ namespace sek
 				return detail::get_opt(get<set_ptr_t<T>>(m_optional), e);
 		}
 
-		const common_set *m_set;
+		const common_set *m_set = nullptr;
+		const detail::component_flags *m_flags = nullptr; /* Flags of the main set if it is enabled-only. */
+		std::array<std::uint8_t, test_count> m_order = {}; /* Order of tests selected by `plan`. */
+		bool m_planned = false;
 		inc_ptr m_included;
 		exc_ptr m_excluded;
 		opt_ptr m_optional;
@@ -316,10 +439,15 @@ namespace sek
 
 	/** @brief Optimized specialization of `component_view` that iterates over a single component set. */
 	template<typename I, typename... P>
-	class component_view<included_t<I>, excluded_t<>, optional_t<P...>>
+	class component_view<included_t<I>, excluded_t<>, optional_t<P...>, enabled_t<>>
 	{
+		static_assert(!detail::bitset_component<std::remove_cv_t<I>>, "View must include at least 1 non-tag component type, use `tag_set::for_each` instead");
+
 		template<typename T>
-		using set_t = transfer_cv_t<T, component_set<std::remove_cv_t<T>>>;
+		using set_t = transfer_cv_t<T,
+									std::conditional_t<detail::bitset_component<std::remove_cv_t<T>>,
+													   tag_set<std::remove_cv_t<T>>,
+													   component_set<std::remove_cv_t<T>>>>;
 		template<typename T>
 		using set_ptr_t = set_t<T> *;
 
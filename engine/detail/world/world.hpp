@@ -4,10 +4,20 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
 
 #include "../../../dense_map.hpp"
 #include "component_set.hpp"
+#include "tag_set.hpp"
 
 namespace sek
 {
@@ -43,12 +53,44 @@ namespace sek
 		constexpr excluded_t() noexcept = default;
 		constexpr excluded_t(type_seq_t<Cs...>) noexcept {}
 	};
+	template<typename... Cs>
+	struct enabled_t
+	{
+		using type = type_seq_t<Cs...>;
+
+		constexpr enabled_t() noexcept = default;
+		constexpr enabled_t(type_seq_t<Cs...>) noexcept {}
+	};
 
 	namespace detail
 	{
 		template<typename...>
 		struct collection_handler;
 
+		/* Returns a hash of the collection's signature, independent of the order of types within each group. */
+		template<typename... O, typename... I, typename... E, typename... Q>
+		[[nodiscard]] inline hash_t collection_signature(owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>) noexcept
+		{
+			constexpr auto combine = [](hash_t seed, hash_t h) noexcept { return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2)); };
+			constexpr auto hash_group = [combine]<std::size_t N>(hash_t seed, hash_t tag, std::array<hash_t, N> hashes) noexcept
+			{
+				std::sort(hashes.begin(), hashes.end());
+				for (auto h : hashes) seed = combine(seed, h);
+				return combine(seed, tag);
+			};
+			constexpr auto type_hash = [](type_info type) noexcept { return fnv1a(type.name().data(), type.name().size()); };
+
+			/* Signature of a collection type never changes, thus only compute it once. */
+			static const hash_t value = [&]()
+			{
+				auto result = hash_group(0, 0, std::array<hash_t, sizeof...(O)>{type_hash(type_info::get<O>())...});
+				result = hash_group(result, 1, std::array<hash_t, sizeof...(I)>{type_hash(type_info::get<I>())...});
+				result = hash_group(result, 2, std::array<hash_t, sizeof...(E)>{type_hash(type_info::get<E>())...});
+				return hash_group(result, 3, std::array<hash_t, sizeof...(Q)>{type_hash(type_info::get<Q>())...});
+			}();
+			return value;
+		}
+
 		class collection_sorter
 		{
 		public:
@@ -64,10 +106,11 @@ namespace sek
 
 			constexpr ~collection_sorter() { m_delete(m_data); }
 
-			template<typename... C, typename... I, typename... E>
-			constexpr explicit collection_sorter(collection_handler<owned_t<C...>, included_t<I...>, excluded_t<E...>> *h)
+			template<typename... C, typename... I, typename... E, typename... Q>
+			constexpr explicit collection_sorter(collection_handler<owned_t<C...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>> *h)
 			{
-				type_count = sizeof...(C) + sizeof...(I) + sizeof...(E);
+				type_count = sizeof...(C) + sizeof...(I) + sizeof...(E) + sizeof...(Q);
+				signature = collection_signature(owned_t<C...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
 
 				if constexpr (sizeof...(C) != 0)
 					is_owned = +[](type_info info) -> bool { return ((type_info::get<C>() == info) || ...); };
@@ -75,36 +118,110 @@ namespace sek
 					is_included = +[](type_info info) -> bool { return ((type_info::get<I>() == info) || ...); };
 				if constexpr (sizeof...(E) != 0)
 					is_excluded = +[](type_info info) -> bool { return ((type_info::get<E>() == info) || ...); };
+				if constexpr (sizeof...(Q) != 0)
+					is_enabled = +[](type_info info) -> bool { return ((type_info::get<Q>() == info) || ...); };
+
+				/* Non-owning collections keep their own set of entities. */
+				if constexpr (sizeof...(C) == 0)
+					m_remap = +[](void *ptr, const entity_remap &table)
+					{ static_cast<decltype(h)>(ptr)->entities.remap(table); };
 
 				m_delete = +[](void *ptr) { delete static_cast<decltype(h)>(ptr); };
 				m_data = h;
 			}
 
 			[[nodiscard]] constexpr void *get() const noexcept { return m_data; }
+			/* Replaces entities of the collection using a remap table. See `entity_world::defragment`. */
+			void remap(const entity_remap &table) const { m_remap(m_data, table); }
 
 			constexpr void swap(collection_sorter &other) noexcept
 			{
 				std::swap(type_count, other.type_count);
+				std::swap(signature, other.signature);
 				std::swap(is_owned, other.is_owned);
 				std::swap(is_included, other.is_included);
 				std::swap(is_excluded, other.is_excluded);
+				std::swap(is_enabled, other.is_enabled);
+				std::swap(m_remap, other.m_remap);
 				std::swap(m_delete, other.m_delete);
 				std::swap(m_data, other.m_data);
 			}
 			friend constexpr void swap(collection_sorter &a, collection_sorter &b) noexcept { a.swap(b); }
 
-			std::size_t type_count; /* Total amount of owned, included & excluded types. */
+			std::size_t type_count; /* Total amount of owned, included, excluded & enabled-only types. */
+			hash_t signature;		/* Hash of the sorted owned, included, excluded & enabled-only types. */
 
 			bool (*is_owned)(type_info info) = +[](type_info) -> bool { return false; };
 			bool (*is_included)(type_info info) = +[](type_info) -> bool { return false; };
 			bool (*is_excluded)(type_info info) = +[](type_info) -> bool { return false; };
+			bool (*is_enabled)(type_info info) = +[](type_info) -> bool { return false; };
 
 		private:
+			void (*m_remap)(void *, const entity_remap &) = +[](void *, const entity_remap &) {};
 			void (*m_delete)(void *) = +[](void *) {};
 			void *m_data = nullptr;
 		};
+
+		/* Bit mask of free entity indices, used to allocate the lowest free index. */
+		class free_index_mask
+		{
+			constexpr static std::size_t word_bits = std::numeric_limits<std::uint64_t>::digits;
+
+		public:
+			[[nodiscard]] constexpr bool empty() const noexcept { return m_count == 0; }
+
+			constexpr void insert(std::size_t i)
+			{
+				const auto word = i / word_bits;
+				if (word >= m_words.size()) m_words.resize(std::max(word + 1, m_words.size() * 2), 0);
+				m_words[word] |= std::uint64_t{1} << (i % word_bits);
+				m_first = m_count++ == 0 ? word : std::min(m_first, word);
+			}
+			[[nodiscard]] constexpr std::size_t pop_lowest() noexcept
+			{
+				SEK_ASSERT(!empty());
+
+				/* Words before `m_first` are always empty, thus the search is amortized `O(1)`. */
+				while (m_words[m_first] == 0) ++m_first;
+				auto &word = m_words[m_first];
+				const auto bit = static_cast<std::size_t>(std::countr_zero(word));
+				word &= word - 1;
+				--m_count;
+				return m_first * word_bits + bit;
+			}
+			constexpr void clear() noexcept
+			{
+				m_words.clear();
+				m_first = 0;
+				m_count = 0;
+			}
+
+			constexpr void swap(free_index_mask &other) noexcept
+			{
+				m_words.swap(other.m_words);
+				std::swap(m_first, other.m_first);
+				std::swap(m_count, other.m_count);
+			}
+			friend constexpr void swap(free_index_mask &a, free_index_mask &b) noexcept { a.swap(b); }
+
+		private:
+			std::vector<std::uint64_t> m_words;
+			std::size_t m_first = 0;
+			std::size_t m_count = 0;
+		};
 	}	 // namespace detail
 
+	/** @brief Policy used by entity worlds to re-use indices of released entities. */
+	enum class recycle_policy
+	{
+		/** Most recently released index is re-used first. Favors indices that are likely still in cache. */
+		lifo,
+		/** Least recently released index is re-used first. Delays version wrap-around of frequently re-used indices. */
+		fifo,
+		/** Lowest free index is re-used first. Keeps indices (and thus sparse arrays of component sets) compact. */
+		lowest,
+	};
+
 	/** @brief A world is a special container used to associate entities with their components.
 	 *
 	 * Internally, a world contains a table of component pools (and dense index arrays) indexed by their type,
@@ -118,6 +235,10 @@ namespace sek
 	{
 		template<typename...>
 		friend struct detail::collection_handler;
+		template<typename, typename, typename, typename, typename, typename>
+		friend class entity_query;
+
+		friend std::span<const entity_t> detail::world_entities(const entity_world &) noexcept;
 
 	public:
 		typedef std::size_t size_type;
@@ -200,7 +321,97 @@ namespace sek
 		};
 
 		using storage_set = dense_set<storage_ptr, storage_hash, storage_cmp>;
+		using tag_map = dense_map<std::string_view, std::unique_ptr<generic_tag_set>>;
+		template<typename T>
+		using storage_t = std::conditional_t<detail::bitset_component<T>, tag_set<T>, component_set<T>>;
 		using sorter_t = detail::collection_sorter;
+		using wire_func = void (*)(generic_component_set &, std::uint8_t);
+
+		/* Resolved storage & collection handler of a query signature. The entry is valid if it's generation
+		 * matches the generation of the world, which is published after the rest of the entry is written. */
+		struct query_entry
+		{
+			std::atomic<std::uint64_t> generation = 0;
+			std::vector<void *> storage; /* Component or tag sets of the query types. */
+			void *handler = nullptr;
+		};
+		/* Table of query entries indexed by query slot. Entries are allocated in segments that are never moved, thus
+		 * valid entries can be read by multiple threads (ex. when constructing views in parallel) without locking,
+		 * while entries are only written under the lock of the cache. Every segment is twice the size of the previous
+		 * one, thus the table grows with the amount of query signatures without an upper bound in practice. */
+		class query_cache
+		{
+			constexpr static std::size_t base_size = 64;
+			constexpr static std::size_t segment_count = 32;
+
+			/* Segment `k` contains `base_size << k` entries, starting at slot `base_size * (2^k - 1)`. */
+			[[nodiscard]] constexpr static std::size_t segment_idx(std::size_t slot) noexcept
+			{
+				return static_cast<std::size_t>(std::bit_width(slot / base_size + 1)) - 1;
+			}
+			[[nodiscard]] constexpr static std::size_t segment_start(std::size_t k) noexcept
+			{
+				return base_size * ((std::size_t{1} << k) - 1);
+			}
+
+		public:
+			query_cache(const query_cache &) = delete;
+			query_cache &operator=(const query_cache &) = delete;
+
+			query_cache() = default;
+			query_cache(query_cache &&other) noexcept { swap(other); }
+			query_cache &operator=(query_cache &&other) noexcept
+			{
+				/* Entries of this cache must not be left to the other one, since they may match it's generation. */
+				auto tmp = query_cache{std::move(other)};
+				swap(tmp);
+				return *this;
+			}
+			~query_cache()
+			{
+				for (auto &s : m_segments) delete[] s.load(std::memory_order_relaxed);
+			}
+
+			[[nodiscard]] query_entry &operator[](std::size_t slot)
+			{
+				const auto k = segment_idx(slot);
+				if (k >= segment_count) [[unlikely]]
+					throw std::length_error("Too many query signatures");
+
+				auto &ptr = m_segments[k];
+				auto *s = ptr.load(std::memory_order_acquire);
+				if (s == nullptr) [[unlikely]]
+				{
+					const std::lock_guard<std::mutex> l(m_mtx);
+					if ((s = ptr.load(std::memory_order_relaxed)) == nullptr)
+						ptr.store(s = new query_entry[base_size << k]{}, std::memory_order_release);
+				}
+				return s[slot - segment_start(k)];
+			}
+			[[nodiscard]] std::mutex &mutex() noexcept { return m_mtx; }
+
+			/* Segments are swapped, while locks belong to the cache instances. */
+			void swap(query_cache &other) noexcept
+			{
+				for (std::size_t i = 0; i < segment_count; ++i)
+				{
+					const auto s = m_segments[i].load(std::memory_order_relaxed);
+					m_segments[i].store(other.m_segments[i].exchange(s, std::memory_order_relaxed), std::memory_order_relaxed);
+				}
+			}
+			friend void swap(query_cache &a, query_cache &b) noexcept { a.swap(b); }
+
+		private:
+			std::mutex m_mtx;
+			std::array<std::atomic<query_entry *>, segment_count> m_segments = {};
+		};
+
+		enum generic_event : std::uint8_t
+		{
+			generic_create = 1,
+			generic_modify = 2,
+			generic_remove = 4,
+		};
 
 		template<bool IsConst>
 		class storage_view
@@ -436,6 +647,8 @@ namespace sek
 		typedef event<void(entity_world &, entity_t)> generic_create_event_type;
 		typedef event<void(entity_world &, entity_t)> generic_modify_event_type;
 		typedef event<void(entity_world &, entity_t)> generic_remove_event_type;
+		typedef event<void(entity_world &, entity_t)> destroy_event_type;
+		typedef event<void(entity_world &, const entity_remap &)> remap_event_type;
 
 		typedef entity_t value_type;
 		typedef const entity_t *pointer;
@@ -472,13 +685,27 @@ namespace sek
 		~entity_world() { clear_storage(); }
 
 		entity_world(entity_world &&other) noexcept
-			: m_storage(std::move(other.m_storage)),
+			: m_arena(std::exchange(other.m_arena, std::make_unique<page_arena>())), /* Moved-from worlds keep a valid arena. */
+			  m_frames(std::exchange(other.m_frames, std::make_unique<frame_arena>())),
+			  m_storage(std::move(other.m_storage)),
+			  m_tags(std::move(other.m_tags)),
 			  m_create(std::move(other.m_create)),
 			  m_modify(std::move(other.m_modify)),
 			  m_remove(std::move(other.m_remove)),
+			  m_destroy(std::move(other.m_destroy)),
+			  m_remap(std::move(other.m_remap)),
+			  m_generic(std::exchange(other.m_generic, {})),
+			  m_wiring(std::move(other.m_wiring)),
+			  m_queries(std::move(other.m_queries)),
+			  m_generation(other.m_generation.exchange(1, std::memory_order_relaxed)),
 			  m_sorters(std::move(other.m_sorters)),
+			  m_sorter_index(std::move(other.m_sorter_index)),
+			  m_transient(std::move(other.m_transient)),
 			  m_entities(std::move(other.m_entities)),
 			  m_next(std::exchange(other.m_next, {})),
+			  m_last(std::exchange(other.m_last, {})),
+			  m_free(std::move(other.m_free)),
+			  m_recycle(other.m_recycle),
 			  m_size(std::exchange(other.m_size, {}))
 		{
 			rebind_storage();
@@ -486,12 +713,26 @@ namespace sek
 		entity_world &operator=(entity_world &&other) noexcept
 		{
 			m_storage = std::move(other.m_storage);
+			m_arena.swap(other.m_arena); /* Both worlds keep an arena, which must outlive sets allocated from it. */
+			m_frames.swap(other.m_frames);
+			m_tags = std::move(other.m_tags);
 			m_create = std::move(other.m_create);
 			m_modify = std::move(other.m_modify);
 			m_remove = std::move(other.m_remove);
+			m_destroy = std::move(other.m_destroy);
+			m_remap = std::move(other.m_remap);
+			m_generic = std::exchange(other.m_generic, {});
+			m_wiring = std::move(other.m_wiring);
+			m_queries = std::move(other.m_queries);
+			m_generation.store(other.m_generation.exchange(1, std::memory_order_relaxed), std::memory_order_relaxed);
 			m_sorters = std::move(other.m_sorters);
+			m_sorter_index = std::move(other.m_sorter_index);
+			m_transient = std::move(other.m_transient);
 			m_entities = std::move(other.m_entities);
 			m_next = std::exchange(other.m_next, {});
+			m_last = std::exchange(other.m_last, {});
+			m_free = std::move(other.m_free);
+			m_recycle = other.m_recycle;
 			m_size = std::exchange(other.m_size, {});
 			rebind_storage();
 			return *this;
@@ -516,6 +757,7 @@ namespace sek
 
 		/** Returns the size of the world (amount of alive entities). */
 		[[nodiscard]] constexpr size_type size() const noexcept { return m_size; }
+
 		/** Checks if the world is empty (does not contain alive entities). */
 		[[nodiscard]] constexpr bool empty() const noexcept { return size() == 0; }
 		/** Returns the max size of the world (absolute maximum of alive entities). */
@@ -523,15 +765,44 @@ namespace sek
 		/** Returns the capacity of the world (current maximum of alive entities) */
 		[[nodiscard]] constexpr size_type capacity() const noexcept { return m_entities.capacity(); }
 
+		/** Returns reference to the page arena used to allocate component pages of the world. See `page_allocator`.
+		 * @note Every world (including moved-from worlds) owns an arena, thus it is safe to call from multiple threads. */
+		[[nodiscard]] page_arena &arena() const noexcept { return *m_arena; }
+		/** Returns reference to the frame arena used to allocate storage of transient components of the world. */
+		[[nodiscard]] frame_arena &frames() const noexcept { return *m_frames; }
+
 		/** Releases all entities, destroys all components.
 		 * @note Does not clear component events. */
 		constexpr void clear()
 		{
 			clear_storage();
+			for (auto &tags : m_tags) tags.second->clear();
 			m_entities.clear();
 			m_next = entity_t::tombstone();
+			m_last = entity_t::index_type::tombstone();
+			m_free.clear();
 			m_size = 0;
 		}
+		/** Ends the current frame. Removes all transient components of the world without destroying them or
+		 * dispatching removal events, then resets the frame arena of the world. Frames of other worlds are not affected.
+		 * Resetting a transient component set is linear in the amount of it's entities, since their sparse entries
+		 * are cleared one by one.
+		 * @note Must not be called concurrently with insertion of transient components.
+		 * @warning Collections must not include transient component types, since they do not observe the reset. */
+		void end_frame()
+		{
+			for (auto &reset : m_transient) reset();
+			m_frames->next_frame();
+		}
+		/** Delivers component events recorded for deferred listeners (see `deferred_t`) since the last flush.
+		 * Events of every component set are delivered in the order of storage creation, ordered by entity within
+		 * each set. Should be called at a synchronization point, after all threads modifying the world have finished.
+		 * @note Immediate listeners are invoked on the thread raising the event, and thus must be thread-safe when
+		 * components are modified from multiple threads. */
+		void flush_events()
+		{
+			for (auto &set : m_storage) set->flush_events();
+		}
 		/** Destroys all components of specified types.
 		 * @note Does not clear component events. */
 		template<typename... Cs>
@@ -548,13 +819,11 @@ namespace sek
 		{
 			if (const auto set = m_storage.find(type); set != m_storage.end()) [[likely]]
 				set->get()->clear();
+			else if (const auto tags = m_tags.find(type); tags != m_tags.end())
+				tags->second->clear();
 		}
 		/** @copydoc clear */
-		constexpr void clear(type_info type)
-		{
-			if (const auto set = m_storage.find(type); set != m_storage.end()) [[likely]]
-				set->get()->clear();
-		}
+		constexpr void clear(type_info type) { clear(type.name()); }
 
 		/** Returns iterator to the specified entity or end iterator if the entity does not exist in the world. */
 		[[nodiscard]] constexpr iterator find(entity_t e) const noexcept
@@ -573,7 +842,12 @@ namespace sek
 		template<typename T, typename... Ts>
 		[[nodiscard]] constexpr bool contains_all(entity_t e) const noexcept
 		{
-			if constexpr (sizeof...(Ts) == 0)
+			if constexpr (sizeof...(Ts) == 0 && detail::bitset_component<std::remove_cv_t<T>>)
+			{
+				const auto tags = get_storage<T>();
+				return tags != nullptr && contains(e) && tags->contains(e);
+			}
+			else if constexpr (sizeof...(Ts) == 0)
 			{
 				const auto storage = m_storage.find(type_info::get<T>());
 				return storage != m_storage.end() && storage->get()->contains(e);
@@ -603,7 +877,12 @@ namespace sek
 		template<typename T, typename... Ts>
 		[[nodiscard]] constexpr bool contains_none(entity_t e) const noexcept
 		{
-			if constexpr (sizeof...(Ts) == 0)
+			if constexpr (sizeof...(Ts) == 0 && detail::bitset_component<std::remove_cv_t<T>>)
+			{
+				const auto tags = get_storage<T>();
+				return tags == nullptr || !contains(e) || !tags->contains(e);
+			}
+			else if constexpr (sizeof...(Ts) == 0)
 			{
 				const auto storage = m_storage.find(type_info::get<T>());
 				return storage == m_storage.end() || !storage->get()->contains(e);
@@ -623,6 +902,8 @@ namespace sek
 		{
 			size_type result = 0;
 			for (auto &set : m_storage) result += set->contains(e);
+			if (contains(e)) [[likely]]
+				for (auto &tags : m_tags) result += tags.second->contains(e);
 			return result;
 		}
 		/** @copydoc size */
@@ -630,7 +911,8 @@ namespace sek
 		/** Checks if the entity is empty (does not have any components). */
 		[[nodiscard]] constexpr bool empty(entity_t e) const noexcept
 		{
-			return std::ranges::none_of(m_storage, [e](auto &set) { return set->contains(e); });
+			return std::ranges::none_of(m_storage, [e](auto &set) { return set->contains(e); }) &&
+				   (!contains(e) || std::ranges::none_of(m_tags, [e](auto &tags) { return tags.second->contains(e); }));
 		}
 		/** @copydoc empty */
 		[[nodiscard]] constexpr bool empty(const_iterator which) const noexcept { return empty(*which); }
@@ -712,6 +994,17 @@ namespace sek
 			return get_storage<C>()->get(e);
 		}
 
+		/** Returns the entity who's component of type `C` has the specified unique key,
+		 * or a tombstone if no such entity exists.
+		 * @note Only available for component types with a unique key (see `component_traits`). */
+		template<typename C, typename K>
+		[[nodiscard]] constexpr entity_t find_by(const K &key) const noexcept
+			requires detail::keyed_component<std::remove_cv_t<C>>
+		{
+			const auto set = get_storage<C>();
+			return set != nullptr ? set->find_by(key) : entity_t::tombstone();
+		}
+
 		/** Creates an entity query for this world. */
 		[[nodiscard]] constexpr auto query() noexcept;
 		/** @copydoc query */
@@ -720,23 +1013,30 @@ namespace sek
 		/** Returns a component view for the specified components.
 		 * @tparam I Components included by the component view.
 		 * @tparam E Components excluded by the component view.
-		 * @tparam O Optional components of the component view. */
-		template<typename... I, typename... E, typename... O>
-		[[nodiscard]] constexpr auto view(excluded_t<E...> = excluded_t<>{}, optional_t<O...> = optional_t<>{}) noexcept;
+		 * @tparam O Optional components of the component view.
+		 * @tparam Q Included components for which the view only accepts enabled components. */
+		template<typename... I, typename... E, typename... O, typename... Q>
+		[[nodiscard]] constexpr auto view(excluded_t<E...> = excluded_t<>{},
+										  optional_t<O...> = optional_t<>{},
+										  enabled_t<Q...> = enabled_t<>{}) noexcept;
 		/** @copydoc view */
-		template<typename... I, typename... E, typename... O>
-		[[nodiscard]] constexpr auto view(excluded_t<E...> = excluded_t<>{}, optional_t<O...> = optional_t<>{}) const noexcept;
+		template<typename... I, typename... E, typename... O, typename... Q>
+		[[nodiscard]] constexpr auto view(excluded_t<E...> = excluded_t<>{},
+										  optional_t<O...> = optional_t<>{},
+										  enabled_t<Q...> = enabled_t<>{}) const noexcept;
 
 		/** Returns a component collection for the specified components.
 		 * @tparam C Components owned (sorted) by the component collection.
 		 * @tparam I Components included by the component view.
 		 * @tparam E Components excluded by the component view.
 		 * @tparam O Optional components of the component view.
+		 * @tparam Q Owned or included components for which the collection only accepts enabled components.
 		 * @note Owned component types are implicitly included. */
-		template<typename... C, typename... I, typename... E, typename... O>
+		template<typename... C, typename... I, typename... E, typename... O, typename... Q>
 		[[nodiscard]] constexpr auto collection(included_t<I...> = included_t<>{},
 												excluded_t<E...> = excluded_t<>{},
-												optional_t<O...> = optional_t<>{}) noexcept;
+												optional_t<O...> = optional_t<>{},
+												enabled_t<Q...> = enabled_t<>{}) noexcept;
 
 		/** Checks if the specified component types are owned by a collection. */
 		template<typename... Cs>
@@ -802,7 +1102,7 @@ namespace sek
 		/** Locks components for the specified entity in place. Pointers to locked components are guaranteed to always
 		 * be stable, however locking a component prevents it from being packed or sorted. */
 		template<typename C, typename... Cs>
-		constexpr void lock(entity_t entity) noexcept
+		constexpr void lock(entity_t entity)
 		{
 			if constexpr (sizeof...(Cs) != 0)
 				(lock<C>(entity), (lock<Cs>(entity), ...));
@@ -811,22 +1111,22 @@ namespace sek
 		}
 		/** @copydoc lock */
 		template<typename C, typename... Cs>
-		constexpr void lock(const_iterator which) noexcept
+		constexpr void lock(const_iterator which)
 		{
 			lock<C, Cs...>(*which);
 		}
 		/** Unlocks any locked components. See `lock`. */
 		template<typename C, typename... Cs>
-		constexpr void unlock(entity_t entity) noexcept
+		constexpr void unlock(entity_t entity)
 		{
 			if constexpr (sizeof...(Cs) != 0)
 				(unlock<C>(entity), (unlock<Cs>(entity), ...));
 			else if (const auto set = get_storage<C>(); set != nullptr) [[likely]]
-				set->lock(entity);
+				set->unlock(entity);
 		}
 		/** @copydoc unlock */
 		template<typename C, typename... Cs>
-		constexpr void unlock(const_iterator which) noexcept
+		constexpr void unlock(const_iterator which)
 		{
 			unlock<C, Cs...>(*which);
 		}
@@ -955,33 +1255,81 @@ namespace sek
 		constexpr void pack()
 		{
 			if constexpr (sizeof...(Cs) != 0) pack<Cs...>();
-			if (auto *storage = get_storage<C>(); storage != nullptr) [[likely]]
-				storage->pack();
+			if constexpr (!detail::bitset_component<std::remove_cv_t<C>>)
+				if (auto *storage = get_storage<C>(); storage != nullptr) [[likely]]
+					storage->pack();
 		}
 
 		/** Generates a new entity.
 		 * @param gen Optional version to use for the entity.
-		 * @return Value of the generated entity. */
+		 * @return Value of the generated entity.
+		 * @throw std::length_error If the amount of entities would exceed `entity_t::index_type::max()`. */
 		[[nodiscard]] constexpr entity_t generate(entity_t::version_type gen = entity_t::version_type::tombstone())
 		{
+			if (!m_free.empty()) return generate_lowest(gen);
 			return m_next.index().is_tombstone() ? generate_new(gen) : generate_existing(gen);
 		}
 
-		/** Releases an entity.
+		/** Returns the policy used to re-use indices of released entities. */
+		[[nodiscard]] constexpr sek::recycle_policy recycle_policy() const noexcept { return m_recycle; }
+		/** Sets the policy used to re-use indices of released entities.
+		 * @note Only affects entities released after the policy was changed. */
+		constexpr void recycle_policy(sek::recycle_policy policy) noexcept { m_recycle = policy; }
+
+		/** Releases an entity. The version of the entity is incremented, so that handles of the released entity
+		 * never compare equal to entities re-using it's index. Indices whose version reached `version_type::max()`
+		 * are retired and never re-used, thus stale handles can not be resurrected by version wrap-around.
 		 * @warning Releasing an entity that contains components will result in stale references. Use `destroy` instead. */
 		constexpr void release(entity_t e)
 		{
-			const auto next_gen = entity_t::version_type{e.version().value() + 1};
 			const auto idx = e.index();
-			m_entities[idx.value()] = entity_t{next_gen, m_next.index()};
-			m_next = entity_t{entity_t::version_type::tombstone(), idx};
 			--m_size;
+
+			/* Tag bits are not versioned, thus have to be cleared before the index can be re-used. */
+			for (auto &tags : m_tags) tags.second->erase(e);
+
+			/* Saturated slots are left as tombstones, which are skipped by iteration and never match any entity. */
+			if (e.version().value() >= entity_t::version_type::max().value()) [[unlikely]]
+			{
+				m_entities[idx.value()] = entity_t::tombstone();
+				return;
+			}
+
+			const auto next_gen = entity_t::version_type{e.version().value() + 1};
+			if (m_recycle == sek::recycle_policy::lowest)
+			{
+				m_entities[idx.value()] = entity_t{next_gen, entity_t::index_type::tombstone()};
+				m_free.insert(idx.value());
+			}
+			else if (m_next.index().is_tombstone())
+			{
+				/* Free list is empty, the released index becomes both it's head & tail. */
+				m_entities[idx.value()] = entity_t{next_gen, entity_t::index_type::tombstone()};
+				m_next = entity_t{entity_t::version_type::tombstone(), idx};
+				m_last = idx;
+			}
+			else if (m_recycle == sek::recycle_policy::fifo)
+			{
+				/* Append to the tail of the free list. */
+				auto &last = m_entities[m_last.value()];
+				last = entity_t{last.version(), idx};
+				m_entities[idx.value()] = entity_t{next_gen, entity_t::index_type::tombstone()};
+				m_last = idx;
+			}
+			else
+			{
+				/* Prepend to the head of the free list. */
+				m_entities[idx.value()] = entity_t{next_gen, m_next.index()};
+				m_next = entity_t{entity_t::version_type::tombstone(), idx};
+			}
 		}
 		/** @copydoc release */
 		constexpr void release(const_iterator which) { release(*which); }
-		/** Destroys all components belonging to the entity and releases it. */
+		/** Destroys all components belonging to the entity and releases it.
+		 * @note Destruction event is dispatched before any components are destroyed. */
 		constexpr void destroy(entity_t e)
 		{
+			m_destroy(*this, e);
 			for (auto &set : m_storage)
 			{
 				if (const auto pos = set->find(e); pos != set->end()) [[unlikely]]
@@ -992,6 +1340,80 @@ namespace sek
 		/** @copydoc destroy */
 		constexpr void destroy(const_iterator which) { destroy(*which); }
 
+		/** Renumbers alive entities of the world to occupy the lowest indices, preserving their relative order,
+		 * and updates entities of all component sets. Offsets of components within their sets are preserved.
+		 * @return Remap table containing the old & new entity of every old index (see `entity_remap`). Stale handles
+		 * (entities with an outdated version) are mapped to a tombstone.
+		 * @note Component sets, collections, pending deferred events and helper objects of the world (hierarchies,
+		 * relations, observers, snapshots and indices) are updated automatically, via the remap event for the latter
+		 * (see `on_remap`). References to entities that are not alive (including stale versions of alive indices) are
+		 * dropped from these structures, since their indices may be re-used. Entities referenced elsewhere must be
+		 * remapped using the returned table.
+		 * @note Versions of moved entities may change, so that stale handles of both the old and the new index
+		 * never match the new entities. */
+		entity_remap defragment()
+		{
+			std::vector<entity_t> table(m_entities.size(), entity_t::tombstone());
+			std::vector<entity_t> alive(m_entities.size(), entity_t::tombstone());
+
+			/* Entities are only ever moved to lower indices, thus every target slot is either dead or vacated. */
+			size_type to = 0;
+			for (size_type from = 0; from < m_entities.size(); ++from)
+			{
+				const auto e = m_entities[from];
+				if (e.index().value() != from) continue; /* Not alive. */
+				alive[from] = e;
+
+				/* Skip retired slots. */
+				while (m_entities[to].version().is_tombstone()) ++to;
+				if (to != from)
+				{
+					/* Dead slots store the next version of their index. */
+					const auto gen = std::max(m_entities[to].version(), e.version());
+					m_entities[to] = table[from] = entity_t{gen, entity_t::index_type{to}};
+					if (e.version().value() >= entity_t::version_type::max().value()) [[unlikely]]
+						m_entities[from] = entity_t::tombstone();
+					else
+					{
+						const auto next_gen = entity_t::version_type{e.version().value() + 1};
+						m_entities[from] = entity_t{next_gen, entity_t::index_type::tombstone()};
+					}
+				}
+				else
+					table[from] = e;
+				++to;
+			}
+
+			/* Rebuild the free list (or mask) from the remaining slots, lowest indices first. */
+			m_next = entity_t::tombstone();
+			m_last = entity_t::index_type::tombstone();
+			m_free.clear();
+			for (auto i = m_entities.size(); i-- > to;)
+			{
+				auto &slot = m_entities[i];
+				if (slot.version().is_tombstone()) continue;
+
+				if (m_recycle == sek::recycle_policy::lowest)
+				{
+					slot = entity_t{slot.version(), entity_t::index_type::tombstone()};
+					m_free.insert(i);
+				}
+				else
+				{
+					if (m_next.index().is_tombstone()) m_last = entity_t::index_type{i};
+					slot = entity_t{slot.version(), m_next.index()};
+					m_next = entity_t{entity_t::version_type::tombstone(), entity_t::index_type{i}};
+				}
+			}
+
+			auto remap = entity_remap{std::move(alive), std::move(table)};
+			for (auto &set : m_storage) set->remap_(remap);
+			for (auto &tags : m_tags) tags.second->remap(remap);
+			for (auto &sorter : m_sorters) sorter.remap(remap);
+			m_remap(*this, remap);
+			return remap;
+		}
+
 		// clang-format off
 		/** Reserves storage for the specified component.
 		 * @param n Amount of components to reserve. If set to `0`, only creates the storage pool.
@@ -999,6 +1421,7 @@ namespace sek
 		template<typename C>
 		constexpr component_set<std::remove_cv_t<C>> &reserve(size_type n = 0)
 		{
+			static_assert(!detail::bitset_component<std::remove_cv_t<C>>, "Bitset tag types do not have component sets, use `storage` instead");
 			return reserve_impl<C>(n);
 		}
 		/** Reserves storage for the specified components.
@@ -1079,7 +1502,11 @@ namespace sek
 		template<typename C, typename... Args>
 		constexpr decltype(auto) emplace_back(entity_t entity, Args &&...args)
 		{
-			return reserve_impl<C>().emplace_back(entity, std::forward<Args>(args)...);
+			/* Tag sets have no dense array, thus tags are always emplaced in-place. */
+			if constexpr (detail::bitset_component<std::remove_cv_t<C>>)
+				return reserve_impl<C>().emplace(entity, std::forward<Args>(args)...);
+			else
+				return reserve_impl<C>().emplace_back(entity, std::forward<Args>(args)...);
 		}
 
 		/** @brief Creates or modifies a component for the specified entity. Tombstones (if any) are re-used.
@@ -1217,25 +1644,63 @@ namespace sek
 		}
 
 		/** Returns event proxy for the generic component creation event.
-		 * This event is invoked when new components of any type are created and added to entities. */
-		[[nodiscard]] constexpr event_proxy<generic_create_event_type> on_create() noexcept { return {m_create}; }
+		 * This event is invoked when new components of any type are created and added to entities.
+		 * @note Component sets only forward events to generic events once the generic event was requested. */
+		[[nodiscard]] event_proxy<generic_create_event_type> on_create()
+		{
+			wire_generic(generic_create);
+			return {m_create};
+		}
 		/** Returns event proxy for the generic component modification event.
-		 * This event is invoked when components of any type are modified via type-specific functions. */
-		[[nodiscard]] constexpr event_proxy<generic_modify_event_type> on_modify() noexcept { return {m_modify}; }
+		 * This event is invoked when components of any type are modified via type-specific functions.
+		 * @note Component sets only forward events to generic events once the generic event was requested. */
+		[[nodiscard]] event_proxy<generic_modify_event_type> on_modify()
+		{
+			wire_generic(generic_modify);
+			return {m_modify};
+		}
 		/** Returns event proxy for the generic component removal event.
-		 * This event is invoked when components of any type are removed from entities and destroyed. */
-		[[nodiscard]] constexpr event_proxy<generic_remove_event_type> on_remove() noexcept { return {m_remove}; }
+		 * This event is invoked when components of any type are removed from entities and destroyed.
+		 * @note Component sets only forward events to generic events once the generic event was requested. */
+		[[nodiscard]] event_proxy<generic_remove_event_type> on_remove()
+		{
+			wire_generic(generic_remove);
+			return {m_remove};
+		}
+		/** Returns event proxy for the entity destruction event.
+		 * This event is invoked when entities are destroyed via `destroy`. */
+		[[nodiscard]] constexpr event_proxy<destroy_event_type> on_destroy() noexcept { return {m_destroy}; }
+		/** Returns event proxy for the entity remap event.
+		 * This event is invoked by `defragment` after entities of the world were renumbered, with the remap table
+		 * of old & new entities (see `entity_remap`). Helper objects referencing entities (ex. hierarchies, relations
+		 * or indices) subscribe to it to update their entities. */
+		[[nodiscard]] constexpr event_proxy<remap_event_type> on_remap() noexcept { return {m_remap}; }
 
 		constexpr void swap(entity_world &other) noexcept
 		{
 			using std::swap;
+			swap(m_arena, other.m_arena);
+			swap(m_frames, other.m_frames);
 			swap(m_storage, other.m_storage);
+			swap(m_tags, other.m_tags);
 			swap(m_create, other.m_create);
 			swap(m_modify, other.m_modify);
 			swap(m_remove, other.m_remove);
+			swap(m_destroy, other.m_destroy);
+			swap(m_remap, other.m_remap);
+			swap(m_generic, other.m_generic);
+			swap(m_wiring, other.m_wiring);
+			swap(m_queries, other.m_queries);
+			m_generation.store(other.m_generation.exchange(m_generation.load(std::memory_order_relaxed), std::memory_order_relaxed),
+							   std::memory_order_relaxed);
 			swap(m_sorters, other.m_sorters);
+			swap(m_sorter_index, other.m_sorter_index);
+			swap(m_transient, other.m_transient);
 			swap(m_entities, other.m_entities);
 			swap(m_next, other.m_next);
+			swap(m_last, other.m_last);
+			swap(m_free, other.m_free);
+			swap(m_recycle, other.m_recycle);
 			swap(m_size, other.m_size);
 
 			/* Rebind storage for both worlds. */
@@ -1244,6 +1709,92 @@ namespace sek
 		}
 
 	private:
+		[[nodiscard]] static std::size_t next_query_slot() noexcept
+		{
+			static std::atomic<std::size_t> value = 0;
+			return value.fetch_add(1, std::memory_order_relaxed);
+		}
+		template<typename K>
+		[[nodiscard]] static std::size_t query_slot() noexcept
+		{
+			static const auto value = next_query_slot();
+			return value;
+		}
+
+		/* Returns cache entry of the query signature `K`. Entries are invalidated when storage is created or
+		 * a collection handler is registered. */
+		template<typename K>
+		[[nodiscard]] query_entry &cached_query()
+		{
+			return m_queries[query_slot<K>()];
+		}
+		[[nodiscard]] bool is_cached(const query_entry &entry) const noexcept
+		{
+			return entry.generation.load(std::memory_order_acquire) == m_generation.load(std::memory_order_acquire);
+		}
+		/* Returns storage for the specified component types, resolved once per cache generation. */
+		template<typename... Ts>
+		[[nodiscard]] std::tuple<storage_t<std::remove_cv_t<Ts>> *...> cached_storage()
+		{
+			using result_t = std::tuple<storage_t<std::remove_cv_t<Ts>> *...>;
+			using key_t = type_seq_t<std::remove_cv_t<Ts>...>;
+
+			const auto get_result = [](const query_entry &entry)
+			{
+				return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+					return result_t{static_cast<storage_t<std::remove_cv_t<Ts>> *>(entry.storage[Is])...};
+				}(std::index_sequence_for<Ts...>{});
+			};
+
+			auto &entry = cached_query<key_t>();
+			if (is_cached(entry)) [[likely]]
+				return get_result(entry);
+
+			/* Another thread may have resolved the entry while waiting for the lock. */
+			const std::lock_guard<std::mutex> l(m_queries.mutex());
+			if (is_cached(entry)) return get_result(entry);
+
+			/* Reserving storage may create new sets & invalidate the cache, thus update the entry afterwards. */
+			const auto result = result_t{std::addressof(reserve_impl<Ts>())...};
+			entry.storage = std::apply([](auto *...sets) { return std::vector<void *>{sets...}; }, result);
+			entry.generation.store(m_generation.load(std::memory_order_acquire), std::memory_order_release);
+			return result;
+		}
+		/* Returns the collection handler `H`, resolved once per cache generation. */
+		template<typename H>
+		[[nodiscard]] H *cached_handler()
+		{
+			auto &entry = cached_query<H>();
+			if (is_cached(entry)) [[likely]]
+				return static_cast<H *>(entry.handler);
+
+			const std::lock_guard<std::mutex> l(m_queries.mutex());
+			if (is_cached(entry)) return static_cast<H *>(entry.handler);
+
+			const auto result = H::make_handler(*this);
+			entry.handler = result;
+			entry.generation.store(m_generation.load(std::memory_order_acquire), std::memory_order_release);
+			return result;
+		}
+
+		template<typename U>
+		static void wire_listeners(generic_component_set &set, std::uint8_t events)
+		{
+			/* Subscribe to type-specific component events to handle generic event dispatching. */
+			auto &storage = static_cast<component_set<U> &>(set);
+			if (events & generic_create) storage.on_create() += delegate_func<&entity_world::create_listener<U>>;
+			if (events & generic_modify) storage.on_modify() += delegate_func<&entity_world::modify_listener<U>>;
+			if (events & generic_remove) storage.on_remove() += delegate_func<&entity_world::remove_listener<U>>;
+		}
+		void wire_generic(std::uint8_t event)
+		{
+			if (m_generic & event) [[likely]]
+				return;
+
+			m_generic |= event;
+			for (auto &[set, wire] : m_wiring) wire(*set, event);
+		}
+
 		[[nodiscard]] constexpr iterator to_iterator(entity_t e) const noexcept
 		{
 			return iterator{m_entities.data() + e.index().value()};
@@ -1253,6 +1804,7 @@ namespace sek
 		{
 			/* Component sets store references to this world and have to be notified on move & swap. */
 			for (auto &set : m_storage) set->rebind(*this);
+			for (auto &tags : m_tags) tags.second->rebind(*this);
 		}
 		constexpr void clear_storage()
 		{
@@ -1262,6 +1814,10 @@ namespace sek
 
 		[[nodiscard]] constexpr entity_t generate_new(entity_t::version_type gen)
 		{
+			/* The last index value is reserved for tombstones. */
+			if (m_entities.size() > entity_t::index_type::max().value()) [[unlikely]]
+				throw std::length_error("Entity world size exceeds maximum entity index");
+
 			const auto idx = entity_t::index_type{m_entities.size()};
 			return (++m_size, !gen.is_tombstone() ? m_entities.emplace_back(gen, idx) : m_entities.emplace_back(idx));
 		}
@@ -1270,30 +1826,50 @@ namespace sek
 			const auto idx = m_next.index();
 			auto &target = m_entities[idx.value()];
 			m_next = entity_t{entity_t::version_type::tombstone(), target.index()};
+			++m_size;
+			return target = entity_t{gen.is_tombstone() ? target.version() : gen, idx};
+		}
+		[[nodiscard]] constexpr entity_t generate_lowest(entity_t::version_type gen)
+		{
+			const auto idx = entity_t::index_type{m_free.pop_lowest()};
+			auto &target = m_entities[idx.value()];
+			++m_size;
 			return target = entity_t{gen.is_tombstone() ? target.version() : gen, idx};
 		}
 
 		template<typename T, typename U = std::remove_cv_t<T>>
-		[[nodiscard]] constexpr component_set<T> *get_storage() noexcept
+		[[nodiscard]] constexpr storage_t<U> *get_storage() noexcept
 		{
-			const auto set = m_storage.find(type_info::get<U>());
-			if (set != m_storage.end()) [[likely]]
+			if constexpr (detail::bitset_component<U>)
+			{
+				const auto tags = m_tags.find(type_info::get<U>().name());
+				return tags != m_tags.end() ? static_cast<tag_set<U> *>(tags->second.get()) : nullptr;
+			}
+			else if (const auto set = m_storage.find(type_info::get<U>()); set != m_storage.end()) [[likely]]
 				return static_cast<component_set<U> *>(set->get());
 			else
 				return nullptr;
 		}
 		template<typename T, typename U = std::remove_cv_t<T>>
-		[[nodiscard]] constexpr const component_set<T> *get_storage() const noexcept
+		[[nodiscard]] constexpr const storage_t<U> *get_storage() const noexcept
 		{
-			const auto set = m_storage.find(type_info::get<U>());
-			if (set != m_storage.end()) [[likely]]
-				return static_cast<const component_set<U> *>(set->get());
-			else
-				return nullptr;
+			return const_cast<entity_world *>(this)->get_storage<U>();
 		}
 
 		template<typename T, typename U = std::remove_cv_t<T>>
-		constexpr component_set<U> &reserve_impl(size_type n = 0)
+		constexpr storage_t<U> &reserve_impl(size_type = 0) requires detail::bitset_component<U>
+		{
+			/* Tag sets are not generic component sets, thus are not wired to generic events. */
+			auto &tags = m_tags[type_info::get<U>().name()];
+			if (tags == nullptr) [[unlikely]]
+			{
+				tags = std::make_unique<tag_set<U>>(*this);
+				++m_generation;
+			}
+			return static_cast<tag_set<U> &>(*tags);
+		}
+		template<typename T, typename U = std::remove_cv_t<T>>
+		constexpr storage_t<U> &reserve_impl(size_type n = 0)
 		{
 			component_set<U> *storage;
 			if (auto target = m_storage.find(type_info::get<U>()); target != m_storage.end()) [[likely]]
@@ -1301,11 +1877,15 @@ namespace sek
 			else
 			{
 				m_storage.emplace(storage = make_set<U>(this));
+				++m_generation;
 
-				/* Subscribe to type-specific component events to handle generic event dispatching. */
-				storage->on_create() += delegate_func<&entity_world::create_listener<U>>;
-				storage->on_modify() += delegate_func<&entity_world::modify_listener<U>>;
-				storage->on_remove() += delegate_func<&entity_world::remove_listener<U>>;
+				/* Generic events are only forwarded from sets once they are requested, thus sets of types without
+				 * listeners do not dispatch events at all. */
+				m_wiring.emplace_back(storage, &entity_world::wire_listeners<U>);
+				if (m_generic != 0) wire_listeners<U>(*storage, m_generic);
+
+				if constexpr (detail::transient_component<U>)
+					m_transient.emplace_back(delegate_func_t<&component_set<U>::reset_frame>{}, storage);
 			}
 
 			if (n != 0) [[likely]]
@@ -1313,36 +1893,52 @@ namespace sek
 			return *storage;
 		}
 
-		template<typename... O, typename... I, typename... E>
-		[[nodiscard]] constexpr auto find_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>) const noexcept
+		template<typename... O, typename... I, typename... E, typename... Q>
+		[[nodiscard]] constexpr auto find_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>) const noexcept
 		{
 			constexpr auto pred = [](const sorter_t &sorter) -> bool
 			{
 				// clang-format off
-				return sorter.type_count == sizeof...(O) + sizeof...(I) + sizeof...(E) &&
+				return sorter.type_count == sizeof...(O) + sizeof...(I) + sizeof...(E) + sizeof...(Q) &&
 					   (sorter.is_owned(type_info::get<O>()) && ...) &&
 					   (sorter.is_included(type_info::get<I>()) && ...) &&
-					   (sorter.is_excluded(type_info::get<E>()) && ...);
+					   (sorter.is_excluded(type_info::get<E>()) && ...) &&
+					   (sorter.is_enabled(type_info::get<Q>()) && ...);
 				// clang-format on
 			};
+
+			/* Look up the sorter by signature. Fall back to a linear search in case of a signature collision. */
+			const auto sig = detail::collection_signature(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
+			if (const auto idx = m_sorter_index.find(sig); idx == m_sorter_index.end()) [[unlikely]]
+				return std::pair{m_sorters.end(), m_sorters.end()};
+			else if (const auto iter = m_sorters.begin() + static_cast<std::ptrdiff_t>(idx->second); pred(*iter)) [[likely]]
+				return std::pair{iter, m_sorters.end()};
 			return std::pair{std::find_if(m_sorters.begin(), m_sorters.end(), pred), m_sorters.end()};
 		}
-		template<typename... O, typename... I, typename... E>
-		[[nodiscard]] constexpr auto next_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>) const noexcept
+		template<typename H>
+		constexpr void add_sorter(H *handler)
+		{
+			++m_generation;
+			const auto &sorter = m_sorters.emplace_back(handler);
+			if (m_sorter_index.find(sorter.signature) == m_sorter_index.end()) [[likely]]
+				m_sorter_index.emplace(sorter.signature, m_sorters.size() - 1);
+		}
+		template<typename... O, typename... I, typename... E, typename... Q>
+		[[nodiscard]] constexpr auto next_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>) const noexcept
 		{
 			constexpr auto pred = [](const sorter_t &s) -> bool {
-				return s.type_count > sizeof...(O) + sizeof...(I) + sizeof...(E) && (s.is_owned(type_info::get<O>()) || ...);
+				return s.type_count > sizeof...(O) + sizeof...(I) + sizeof...(E) + sizeof...(Q) && (s.is_owned(type_info::get<O>()) || ...);
 			};
 			return std::pair{std::find_if(m_sorters.begin(), m_sorters.end(), pred), m_sorters.end()};
 		}
-		template<typename... O, typename... I, typename... E>
-		[[nodiscard]] constexpr auto prev_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>) const noexcept
+		template<typename... O, typename... I, typename... E, typename... Q>
+		[[nodiscard]] constexpr auto prev_sorter(owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>) const noexcept
 		{
 			constexpr auto pred = [](const sorter_t &s) -> bool { return (s.is_owned(type_info::get<O>()) || ...); };
 			return std::pair{std::find_if(m_sorters.begin(), m_sorters.end(), pred), m_sorters.end()};
 		}
-		template<typename... O, typename... I, typename... E>
-		[[nodiscard]] constexpr bool has_conflicts(owned_t<O...>, included_t<I...>, excluded_t<E...>) const noexcept
+		template<typename... O, typename... I, typename... E, typename... Q>
+		[[nodiscard]] constexpr bool has_conflicts(owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>) const noexcept
 		{
 			constexpr auto pred = [](const sorter_t &s) -> bool
 			{
@@ -1351,42 +1947,107 @@ namespace sek
 				else
 				{
 					const auto weak = (0lu + ... + s.is_included(type_info::get<I>())) +
-									  (0lu + ... + s.is_excluded(type_info::get<E>()));
+									  (0lu + ... + s.is_excluded(type_info::get<E>())) +
+									  (0lu + ... + s.is_enabled(type_info::get<Q>()));
 					const auto count = weak + overlap;
-					return !(count == (sizeof...(O) + sizeof...(I) + sizeof...(E)) || count == s.type_count);
+					return !(count == (sizeof...(O) + sizeof...(I) + sizeof...(E) + sizeof...(Q)) || count == s.type_count);
 				}
 			};
 			return std::any_of(m_sorters.begin(), m_sorters.end(), pred);
 		}
 
+		/* Arena must outlive component sets, thus it is declared before (and destroyed after) them. */
+		std::unique_ptr<page_arena> m_arena = std::make_unique<page_arena>();
+		std::unique_ptr<frame_arena> m_frames = std::make_unique<frame_arena>(); /* Storage of transient components. */
 		storage_set m_storage;
+		tag_map m_tags; /* Tag sets of bitset tag types, indexed by type name. */
 		generic_event_type m_create;
 		generic_event_type m_modify;
 		generic_event_type m_remove;
+		destroy_event_type m_destroy;
+		remap_event_type m_remap;
+
+		std::uint8_t m_generic = 0; /* Generic events that are forwarded from component sets. */
+		std::vector<std::pair<generic_component_set *, wire_func>> m_wiring;
+
+		query_cache m_queries;			/* Query cache, indexed by query slot. */
+		std::atomic<std::uint64_t> m_generation = 1; /* Generation of the query cache. */
 
 		std::vector<sorter_t> m_sorters;
+		dense_map<hash_t, std::size_t> m_sorter_index; /* Signature -> offset of the sorter within `m_sorters`. */
+		std::vector<delegate<void()>> m_transient; /* Reset functions of transient component sets. */
 		std::vector<entity_t> m_entities;
 
-		entity_t m_next = entity_t::tombstone();
+		entity_t m_next = entity_t::tombstone();					 /* Head of the free list. */
+		entity_t::index_type m_last = entity_t::index_type::tombstone(); /* Tail of the free list. */
+		detail::free_index_mask m_free; /* Free indices, used by the `lowest` recycle policy. */
+		sek::recycle_policy m_recycle = sek::recycle_policy::lifo;
 		size_type m_size = 0; /* Amount of alive entities within the world. */
 	};
 
 	namespace detail
 	{
-		template<typename... O, typename... I, typename... E>
-		struct collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>>
+		inline page_arena &world_arena(entity_world &world) { return world.arena(); }
+		inline frame_arena &world_frame_arena(entity_world &world) { return world.frames(); }
+		inline std::span<const entity_t> world_entities(const entity_world &world) noexcept { return {world.m_entities}; }
+
+		/* Invokes `f(i)` for every `i` in `[0, n)`, where `f(0)` runs on the calling thread and the rest on worker
+		 * threads. Exceptions thrown by the workers are captured, and the first one is re-thrown on the calling
+		 * thread once all workers have finished. */
+		template<typename F>
+		void parallel_invoke(std::size_t n, F &&f)
 		{
+			if (n == 0) [[unlikely]]
+				return;
+
+			std::vector<std::exception_ptr> errors(n);
+			const auto run = [&](std::size_t i) noexcept
+			{
+				try
+				{
+					f(i);
+				}
+				catch (...)
+				{
+					errors[i] = std::current_exception();
+				}
+			};
+			{
+				std::vector<std::jthread> workers;
+				workers.reserve(n - 1);
+				for (std::size_t i = 1; i < n; ++i) workers.emplace_back(run, i);
+				run(0);
+			}
+			for (auto &error : errors)
+				if (error) std::rethrow_exception(error);
+		}
+
+		template<typename... O, typename... I, typename... E, typename... Q>
+		struct collection_handler<owned_t<O...>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>>
+		{
+			template<typename U, typename S>
+			[[nodiscard]] constexpr static bool accept_enabled(const S *set, entity_t e) noexcept
+			{
+				if constexpr (is_in_v<U, Q...>)
+					return set->is_enabled(e);
+				else
+					return true;
+			}
 			template<typename T>
 			[[nodiscard]] constexpr static bool accept(entity_world &w, std::tuple<component_set<O> *...> o, entity_t e) noexcept
 			{
 				constexpr auto accept_owned = []<typename U>(type_selector_t<U>, std::tuple<component_set<O> *...> o, entity_t e)
 				{
 					const auto set = std::get<component_set<U> *>(o);
-					return (std::is_same_v<T, U> || set->contains(e)) && !set->is_locked(e);
+					return (std::is_same_v<T, U> || set->contains(e)) && !set->is_locked(e) && accept_enabled<U>(set, e);
+				};
+				constexpr auto accept_included = []<typename U>(type_selector_t<U>, entity_world &w, entity_t e)
+				{
+					const auto set = w.template get_storage<U>();
+					return (std::is_same_v<T, U> || set->contains(e)) && accept_enabled<U>(set, e);
 				};
 
-				return ((accept_owned(type_selector<O>, o, e) && ...) &&
-						((std::is_same_v<T, I> || w.template get_storage<I>()->contains(e)) && ...) &&
+				return ((accept_owned(type_selector<O>, o, e) && ...) && (accept_included(type_selector<I>, w, e) && ...) &&
 						((std::is_same_v<T, E> || !w.template get_storage<E>()->contains(e)) && ...));
 			}
 			[[nodiscard]] constexpr static std::tuple<component_set<O> *...> get_storage(entity_world &world) noexcept
@@ -1396,10 +2057,10 @@ namespace sek
 
 			[[nodiscard]] static collection_handler *make_handler(entity_world &world)
 			{
-				auto sorter = world.find_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{});
+				auto sorter = world.find_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
 				if (sorter.first == sorter.second)
 				{
-					SEK_ASSERT(!world.has_conflicts(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}),
+					SEK_ASSERT(!world.has_conflicts(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{}),
 							   "Conflicting collections detected");
 
 					// clang-format off
@@ -1417,13 +2078,17 @@ namespace sek
 					{
 						set.on_lock().subscribe(delegate{delegate_func_t<&collection_handler::template handle_locked<T>>{}, h});
 					};
+					[[maybe_unused]] constexpr auto sub_enabled = []<typename T>(component_set<T> &set, collection_handler *h)
+					{
+						set.on_enable().subscribe(delegate{delegate_func_t<&collection_handler::template handle_enabled<T>>{}, h});
+					};
 					// clang-format on
 
 					/* Next collection should be the more restricted one, while the previous is the less restricted one.
 					 * Since collections sort their components, the most-restricted collection will sort inside the
 					 * least-restricted one. */
-					const auto next = world.next_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{});
-					const auto prev = world.prev_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{});
+					const auto next = world.next_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
+					const auto prev = world.prev_sorter(owned_t<O...>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
 
 					const void *next_handler = (next.first == next.second ? nullptr : next.first->get());
 					const void *prev_handler = (prev.first == prev.second ? nullptr : prev.first->get());
@@ -1431,6 +2096,8 @@ namespace sek
 
 					/* Handle locking for all owned types. */
 					(sub_locked(world.template reserve<O>(), handler), ...);
+					/* Handle enabling & disabling for all enabled-only types. */
+					(sub_enabled(world.template reserve<Q>(), handler), ...);
 
 					/* Handle addition and removal of new components for owned, included and excluded types. */
 					(sub_include(world.template reserve<O>(), next_handler, prev_handler, handler), ...);
@@ -1438,16 +2105,16 @@ namespace sek
 					(sub_exclude(world.template reserve<E>(), next_handler, prev_handler, handler), ...);
 
 					/* Go through all owned entities & sort their components. */
-					handler->template sort_entities<O...>(world);
+					handler->sort_entities(world);
 
-					world.m_sorters.emplace_back(handler);
+					world.add_sorter(handler);
 					return handler;
 				}
 				return static_cast<collection_handler *>(sorter.first->get());
 			}
 
 			template<typename T>
-			constexpr void swap_entities(component_set<T> *storage, std::size_t a, entity_t b)
+			constexpr static void swap_entities(component_set<T> *storage, std::size_t a, entity_t b)
 			{
 				const auto b_idx = storage->offset(b);
 				if (a != b_idx) storage->swap(a, b_idx);
@@ -1463,16 +2130,58 @@ namespace sek
 				(swap_entities(get<component_set<O> *>(storage), last_pos, entity), ...);
 			}
 
-			constexpr void sort_entities(entity_world &world)
+			/* Minimum amount of entities in the first owned set for which the initial sort is done in parallel. */
+			constexpr static std::size_t parallel_threshold = 1 << 16;
+
+			[[nodiscard]] static std::vector<entity_t> accepted_entities(entity_world &world, std::tuple<component_set<O> *...> storage)
 			{
 				using T = type_seq_element_t<0, type_seq_t<O...>>;
 
+				const auto *data = std::get<0>(storage)->data();
+				const auto count = std::get<0>(storage)->size();
+				const auto accept_range = [&](std::size_t first, std::size_t last, std::vector<entity_t> &out)
+				{
+					for (auto i = first; i != last; ++i)
+						if (const auto e = data[i]; !e.is_tombstone() && accept<T>(world, storage, e)) out.push_back(e);
+				};
+
+				/* Acceptance only reads component sets, thus the owned set is split into chunks checked in parallel.
+				 * Chunks are concatenated in order, so that accepted entities keep their relative order. */
+				const auto threads = count < parallel_threshold ? 1 : std::max(std::thread::hardware_concurrency(), 1u);
+				std::vector<std::vector<entity_t>> chunks(threads);
+				const auto chunk_size = (count + threads - 1) / threads;
+				parallel_invoke(threads,
+								[&](std::size_t i)
+								{
+									const auto first = std::min(i * chunk_size, count);
+									accept_range(first, std::min(first + chunk_size, count), chunks[i]);
+								});
+
+				auto result = std::move(chunks[0]);
+				for (std::size_t i = 1; i < threads; ++i) result.insert(result.end(), chunks[i].begin(), chunks[i].end());
+				return result;
+			}
+			void sort_entities(entity_world &world)
+			{
 				const auto storage = get_storage(world);
-				for (auto count = std::get<0>(storage)->size(), i = 0; i != count; ++i)
+				const auto accepted = accepted_entities(world, storage);
+
+				/* Move accepted entities to the front of every owned set. Owned sets are independent of each other,
+				 * thus every set is partitioned on it's own thread. */
+				const auto partition = [&accepted]<typename U>(component_set<U> *set)
 				{
-					const auto entity = std::get<0>(storage)->data()[i];
-					if (size <= i && accept<T>(world, storage, entity)) add_entity(storage, entity);
-				}
+					for (std::size_t i = 0; i < accepted.size(); ++i) swap_entities(set, i, accepted[i]);
+				};
+				if (accepted.size() < parallel_threshold || sizeof...(O) == 1)
+					(partition(std::get<component_set<O> *>(storage)), ...);
+				else
+					parallel_invoke(sizeof...(O),
+									[&](std::size_t i)
+									{
+										std::size_t j = 0;
+										((j++ == i ? partition(std::get<component_set<O> *>(storage)) : void()), ...);
+									});
+				size = accepted.size();
 			}
 
 			template<typename T>
@@ -1502,6 +2211,15 @@ namespace sek
 				else
 					handle_create<T>(world, entity);
 			}
+			template<typename T>
+			void handle_enabled(entity_world &world, entity_t entity, bool is_enabled)
+			{
+				/* Disabled components are treated the same way as locked ones. */
+				if (!is_enabled)
+					handle_remove<T>(world, entity);
+				else
+					handle_create<T>(world, entity);
+			}
 
 			[[nodiscard]] constexpr bool contains(std::tuple<component_set<O> *...> storage, entity_t entity) const noexcept
 			{
@@ -1510,15 +2228,15 @@ namespace sek
 
 			std::size_t size = 0;
 		};
-		template<typename... I, typename... E>
-		struct collection_handler<owned_t<>, included_t<I...>, excluded_t<E...>>
+		template<typename... I, typename... E, typename... Q>
+		struct collection_handler<owned_t<>, included_t<I...>, excluded_t<E...>, enabled_t<Q...>>
 		{
 			[[nodiscard]] static collection_handler *make_handler(entity_world &world)
 			{
-				auto sorter = world.find_sorter(owned_t<>{}, included_t<I...>{}, excluded_t<E...>{});
+				auto sorter = world.find_sorter(owned_t<>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{});
 				if (sorter.first == sorter.second)
 				{
-					SEK_ASSERT(!world.has_conflicts(owned_t<>{}, included_t<I...>{}, excluded_t<E...>{}),
+					SEK_ASSERT(!world.has_conflicts(owned_t<>{}, included_t<I...>{}, excluded_t<E...>{}, enabled_t<Q...>{}),
 							   "Conflicting collections detected");
 
 					[[maybe_unused]] constexpr auto sub_include = []<typename T>(component_set<T> &set, collection_handler *h)
@@ -1531,17 +2249,22 @@ namespace sek
 						set.on_create() += delegate{delegate_func_t<&collection_handler::template handle_remove<T>>{}, h};
 						set.on_remove() += delegate{delegate_func_t<&collection_handler::template handle_create<T>>{}, h};
 					};
+					[[maybe_unused]] constexpr auto sub_enabled = []<typename T>(component_set<T> &set, collection_handler *h)
+					{
+						set.on_enable() += delegate{delegate_func_t<&collection_handler::template handle_enabled<T>>{}, h};
+					};
 					auto *handler = new collection_handler{};
 
 					/* Handle addition and removal of new components for both included and excluded types. */
 					(sub_include(world.template reserve<I>(), handler), ...);
 					(sub_exclude(world.template reserve<E>(), handler), ...);
+					(sub_enabled(world.template reserve<Q>(), handler), ...);
 
 					/* Fill the collection with the contents of a view. */
-					const auto view = world.template view<I...>(excluded_t<E...>{});
+					const auto view = world.template view<I...>(excluded_t<E...>{}, optional_t<>{}, enabled_t<Q...>{});
 					handler->entities.insert(view.begin(), view.end());
 
-					world.m_sorters.emplace_back(handler);
+					world.add_sorter(handler);
 					return handler;
 				}
 				else
@@ -1553,10 +2276,19 @@ namespace sek
 			{
 				/* If the entity is accepted, try to insert it into the set. */
 				if (((std::is_same_v<C, I> || world.reserve<I>().contains(entity)) && ...) &&
-					((std::is_same_v<C, E> || !world.reserve<E>().contains(entity)) && ...))
+					((std::is_same_v<C, E> || !world.reserve<E>().contains(entity)) && ...) &&
+					(world.reserve<Q>().is_enabled(entity) && ...))
 					entities.try_insert(entity);
 			}
 			template<typename C>
+			void handle_enabled(entity_world &world, entity_t entity, bool is_enabled)
+			{
+				if (!is_enabled)
+					handle_remove<C>(world, entity);
+				else
+					handle_create<C>(world, entity);
+			}
+			template<typename C>
 			void handle_remove(entity_world &, entity_t entity)
 			{
 				/* Remove the asset. */
@@ -1590,5 +2322,15 @@ namespace sek
 
 			return std::addressof(pos->second);
 		}
+		template<typename T>
+		constexpr auto get_opt(tag_set<T> *set, entity_t e) noexcept -> T *
+		{
+			return set != nullptr && set->contains(e) ? std::addressof(set->get(e)) : nullptr;
+		}
+		template<typename T>
+		constexpr auto get_opt(const tag_set<T> *set, entity_t e) noexcept -> std::add_const_t<T> *
+		{
+			return set != nullptr && set->contains(e) ? std::addressof(set->get(e)) : nullptr;
+		}
 	}	 // namespace detail
 }	 // namespace sek
\ No newline at end of file